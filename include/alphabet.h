@@ -0,0 +1,60 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_ALPHABET_H_
+#define INCLUDE_ALPHABET_H_
+
+#include <string>
+
+#include "include/bit_string.h"
+#include "include/structures.h"
+
+// Channel alphabet of kRadix symbols. Elementary codes are strings of digits
+// '0', '1', ... if radix is not more than 10 and strings of bytes otherwise.
+template<int kRadix>
+struct Alphabet {
+  typedef std::string Word;
+
+  static const int kFirstChar = (kRadix <= 10 ? '0' : 0);
+
+  static void Pack(ElementaryCode* elem_code) {
+    elem_code->bits.Assign(std::string());
+  }
+
+  static const Word& GetWord(const ElementaryCode& elem_code) {
+    return elem_code.str;
+  }
+
+  static unsigned GetLength(const Word& word) {
+    return word.size();
+  }
+
+  static int GetSymbol(const Word& word, unsigned pos) {
+    return static_cast<unsigned char>(word[pos]) - kFirstChar;
+  }
+};
+
+// Binary codes are read from packed bits.
+template<>
+struct Alphabet<2> {
+  typedef BitString Word;
+
+  static void Pack(ElementaryCode* elem_code) {
+    elem_code->bits.Assign(elem_code->str);
+  }
+
+  static const Word& GetWord(const ElementaryCode& elem_code) {
+    return elem_code.bits;
+  }
+
+  static unsigned GetLength(const Word& word) {
+    return word.length();
+  }
+
+  static int GetSymbol(const Word& word, unsigned pos) {
+    return word.GetBit(pos);
+  }
+};
+
+#endif  // INCLUDE_ALPHABET_H_
@@ -5,18 +5,37 @@
 #ifndef INCLUDE_ALPHABETIC_ENCODER_H_
 #define INCLUDE_ALPHABETIC_ENCODER_H_
 
+#include <stdint.h>
+
 #include <vector>
 #include <string>
 
 #include "include/state_machine.h"
 #include "include/bijective_checker.h"
+#include "include/prepared_machine.h"
+#include "include/thread_pool.h"
 
 class AlphabeticEncoder {
  public:
   explicit AlphabeticEncoder(const std::string& config_file);
 
+  AlphabeticEncoder(const std::vector<std::string>& code,
+                    const StateMachine& state_machine);
+
+  ~AlphabeticEncoder();
+
   bool CheckBijective();
 
+  // Encodes word of elementary codes ids. Bit i of encoded word is bit
+  // (i % 8) of byte i / 8 of data (from least significant bit). Returns false
+  // if word is not recognized by code state machine, data is undefined then.
+  bool Encode(const int* symbols, unsigned n_symbols,
+              std::vector<uint8_t>* data, uint64_t* n_bits) const;
+
+  // Number of threads for encoding. Long words are split to chunks which are
+  // encoded in parallel straight to output. Single thread by default.
+  void SetNumberThreads(int n_threads);
+
   void WriteCodeStateMachine(const std::string& file_path) const;
 
   void WriteDeficitsStateMachine(const std::string& file_path);
@@ -32,9 +51,46 @@ class AlphabeticEncoder {
                               const StateMachine& state_machine);
 
  private:
+  static const unsigned kMaxNextStatesTableSize;
+  // Elementary codes are packed by words of this number of bits.
+  static const unsigned kMaxWordBits;
+  // Words are split to chunks of at least this number of symbols and up to
+  // this number of chunks per thread for balancing.
+  static const unsigned kMinChunkSize;
+  static const unsigned kNumChunksPerThread;
+  // Chunks are checked by code state machine from every state if it has up to
+  // this number of states. Otherwise word is checked sequentially.
+  static const unsigned kMaxNumberTrackedStates;
+
+  // Packs elementary codes and prepares state machine for encoding.
+  void PrepareEncoding();
+
+  bool EncodeConcurrently(const int* symbols, unsigned n_symbols,
+                          std::vector<uint8_t>* data, uint64_t* n_bits) const;
+
+  // Writes codes of symbols from bit_offset of bytes. Only bytes which are
+  // fully covered by chunk are written. Bits of the first and the last
+  // partial bytes are returned by head and tail (chunk may cover part of single
+  // byte, it's the tail then).
+  void EncodeChunk(const int* symbols, unsigned n_symbols,
+                   uint64_t bit_offset, uint8_t* bytes, uint8_t* head,
+                   uint8_t* tail) const;
+
   BijectiveChecker bijective_checker;
   StateMachine state_machine_;
   std::vector<std::string> elem_codes_;
+
+  PreparedMachine prepared_machine_;
+  bool accepts_all_words_;
+  // Next states of prepared machine by state * number of codes + code id.
+  // Empty if machine accepts all words or table is too large.
+  std::vector<int> next_states_;
+  // Bits of elementary code i by kMaxWordBits bits per word in range
+  // [offsets[i], offsets[i + 1]) of codes words.
+  std::vector<uint64_t> codes_words_;
+  std::vector<unsigned> codes_offsets_;
+  std::vector<unsigned> codes_lengths_;
+  ThreadPool* thread_pool_;
 };
 
 #endif  // INCLUDE_ALPHABETIC_ENCODER_H_
@@ -0,0 +1,64 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_BATCH_BIJECTIVE_CHECKER_H_
+#define INCLUDE_BATCH_BIJECTIVE_CHECKER_H_
+
+#include <vector>
+#include <string>
+
+#include "include/bijective_checker.h"
+#include "include/prepared_code.h"
+#include "include/state_machine.h"
+#include "include/thread_pool.h"
+
+// Code and state machine for checking. Code is set by strings or by prepared
+// code, which may be shared between problems. Nothing is owned, all objects
+// must be alive until check is finished.
+struct BijectivityProblem {
+  BijectivityProblem();
+
+  BijectivityProblem(const std::vector<std::string>* code,
+                     const StateMachine* code_state_machine);
+
+  BijectivityProblem(const PreparedCodeBase* prepared_code,
+                     const StateMachine* code_state_machine);
+
+  const std::vector<std::string>* code;
+  const PreparedCodeBase* prepared_code;
+  const StateMachine* code_state_machine;
+};
+
+struct BijectivityResult {
+  bool is_bijective;
+  // Words with the same encoding if code is not bijective and words are
+  // requested.
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+};
+
+// Checks many problems by several threads. Each thread uses it's own
+// BijectiveChecker so their memory is reused between problems.
+class BatchBijectiveChecker {
+ public:
+  explicit BatchBijectiveChecker(int n_threads);
+
+  ~BatchBijectiveChecker();
+
+  void IsBijective(const BijectivityProblem* problems, unsigned n_problems,
+                   bool extract_words, std::vector<BijectivityResult>* results);
+
+  void IsBijective(const std::vector<BijectivityProblem>& problems,
+                   bool extract_words, std::vector<BijectivityResult>* results);
+
+ private:
+  BatchBijectiveChecker(const BatchBijectiveChecker&);
+  BatchBijectiveChecker& operator=(const BatchBijectiveChecker&);
+
+  ThreadPool thread_pool_;
+  // Checker per thread.
+  std::vector<BijectiveChecker*> checkers_;
+};
+
+#endif  // INCLUDE_BATCH_BIJECTIVE_CHECKER_H_
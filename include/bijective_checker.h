@@ -5,16 +5,34 @@
 #ifndef INCLUDE_BIJECTIVE_CHECKER_H_
 #define INCLUDE_BIJECTIVE_CHECKER_H_
 
+#include <stdint.h>
+
 #include <vector>
 #include <queue>
 #include <string>
 
 #include "include/state_machine.h"
 #include "include/structures.h"
-#include "include/code_tree.h"
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/synonymy_states_map.h"
+#include "include/thread_pool.h"
 
 class BijectiveChecker {
  public:
+  // Stages of check. Cheap checks of code properties are tried before search
+  // of synonymy loop.
+  enum CheckTier {
+    // Code has equal elementary codes and state machine accepts all words.
+    DUPLICATES_TIER,
+    PREFIX_FREE_TIER,
+    SUFFIX_FREE_TIER,
+    // McMillan's inequality is violated and state machine accepts all words.
+    // Skipped if words of the same encoding are requested.
+    MCMILLAN_TIER,
+    SYNONYMY_LOOP_TIER
+  };
+
   BijectiveChecker();
 
   ~BijectiveChecker();
@@ -24,39 +42,116 @@ class BijectiveChecker {
                    std::vector<int>* first_bad_word = 0,
                    std::vector<int>* second_bad_word = 0);
 
-  void WriteDeficitsStateMachine(const std::string& file_path);
+  // Check of code over alphabet of kRadix symbols (see Alphabet). Code is
+  // prepared by each call and isn't kept, so state machines of this check
+  // can't be written. Use BasicPreparedCode for repeated checks.
+  template<int kRadix>
+  bool IsBijective(const std::vector<std::string>& code,
+                   const StateMachine& code_state_machine,
+                   std::vector<int>* first_bad_word = 0,
+                   std::vector<int>* second_bad_word = 0) {
+    BasicPreparedCode<kRadix> prepared_code(code);
+    const bool is_bijective = IsBijective(prepared_code, code_state_machine,
+                                          first_bad_word, second_bad_word);
+    code_ = 0;
+    return is_bijective;
+  }
+
+  // Check of code prepared once for many code state machines. Code of any
+  // alphabet may be used. Code must be alive while states machines of this
+  // check are written.
+  bool IsBijective(const PreparedCodeBase& code,
+                   const StateMachine& code_state_machine,
+                   std::vector<int>* first_bad_word = 0,
+                   std::vector<int>* second_bad_word = 0);
+
+  // Check of prepared code and prepared code state machine. Both may be
+  // reused by many checks.
+  bool IsBijective(const PreparedCodeBase& code,
+                   const PreparedMachine& code_machine,
+                   std::vector<int>* first_bad_word = 0,
+                   std::vector<int>* second_bad_word = 0);
+
+  // Search synonymy loop from both start and end states of synonymy state
+  // machine. It's useful for codes with long ambiguities. Codes with equal
+  // elementary codes are checked by forward search.
+  void SetBidirectionalSearch(bool bidirectional);
 
-  void WriteSynonymyStateMachine(const std::string& file_path);
+  // Number of threads for forward search. Big levels of breadth-first search
+  // are processed in parallel. Found words are the same for any number of
+  // threads. Single thread by default.
+  void SetNumberThreads(int n_threads);
 
- private:
-  void BuildDeficitsStateMachine(const CodeTree& code_tree);
+  // Tier which has decided result of the last check.
+  CheckTier GetLastCheckTier() const;
 
-  void AddIsotropicDeficits(int deficit_id,
-                            const CodeTree& code_tree,
-                            std::queue<int>* deficits_up_to_build);
+  // State machines of the last check. Return false and write nothing if
+  // there was no check or its code isn't kept (see IsBijective<kRadix>).
+  bool WriteDeficitsStateMachine(const std::string& file_path);
 
-  void AddAntitropicDeficits(int deficit_id,
-                             const CodeTree& code_tree,
-                             std::queue<int>* deficits_up_to_build);
+  bool WriteSynonymyStateMachine(const std::string& file_path);
 
+ private:
   void BuildSynonymyStateMachine();
 
   struct SynonymyState {
     State* deficit;
-    State* upper_state;
-    State* lower_state;
-    int* sequence;
+    // States ids of code state machine.
+    int upper_state;
+    int lower_state;
+    // Index of previous state at queue of synonymy states (-1 for first one)
+    // and symbol of transition from it. Symbol is positive (code id + 1) for
+    // upper word and negative (-code id - 1) for lower one, 0 for root state.
+    // At backward search parent is the next state and symbol is of transition
+    // to it.
+    int parent;
+    int symbol;
     bool is_tivial;
 
-    unsigned Hash(unsigned n_code_sm_states);
+    uint64_t Hash(unsigned n_code_sm_states) const;
 
-    static unsigned Hash(unsigned deficit_id, unsigned upper_state_id,
+    static uint64_t Hash(unsigned deficit_id, unsigned upper_state_id,
                          unsigned lower_state_id, unsigned n_code_sm_states);
   };
 
+  // Three visiting states for each synonymy state at bidirectional search.
+  enum VisitingState { FREE, FREE_FOR_NONTRIVIAL, BUSY };
+
+  // Visiting bits of each synonymy state at forward search: reached by
+  // trivial path and reached by not trivial one. State is visited by both
+  // kinds of paths independently so result doesn't depend on order of
+  // visiting.
+  enum VisitingBit { TRIVIAL_VISITED = 1, NONTRIVIAL_VISITED = 2 };
+
   bool FindSynonymyLoop(std::vector<int>* first_bad_word = 0,
                         std::vector<int>* second_bad_word = 0);
 
+  // Processes level [level_begin, level_end) of forward search by several
+  // threads. Returns index of chunk with found end state or -1.
+  int ProcessLevelConcurrently(unsigned level_begin, unsigned level_end,
+                               uint64_t end_syn_hash);
+
+  // Breadth-first search from start state by transitions and from end
+  // state by reversed transitions until they meet.
+  bool FindSynonymyLoopBidirectional(std::vector<int>* first_bad_word = 0,
+                                     std::vector<int>* second_bad_word = 0);
+
+  // States reachable from this one by single transition.
+  void GetNextSynonymyStates(const SynonymyState& syn_state,
+                             std::vector<SynonymyState>* next_states);
+
+  // States from which this one is reachable by single transition.
+  void GetPrevSynonymyStates(const SynonymyState& syn_state,
+                             std::vector<SynonymyState>* prev_states);
+
+  // Appends symbols of states from the root one by parent links up to this
+  // state. Reversed order if from_root is false.
+  void AppendSynonymyWords(const std::vector<SynonymyState>& syn_states,
+                           int state_idx, bool from_root,
+                           std::vector<int>* first_word,
+                           std::vector<int>* second_word);
+
+  // Makes checker empty in O(1). All objects are kept for next check.
   void Reset();
 
   // From (-3 -2 -1 0 1 2 3)
@@ -67,12 +162,29 @@ class BijectiveChecker {
   // To (-3 -2 -1 0 1 2 3)
   inline int SignedDeficitId(unsigned id);
 
-  std::vector<ElementaryCode*> code_;
-  std::vector<Suffix*> code_suffixes_;
-  StateMachine* deficits_state_machine_;
-  StateMachine* synonymy_state_machine_;
-  // Just reference for private methods.
-  const StateMachine* code_state_machine_;
+  StateMachine synonymy_state_machine_;
+  // Just references for private methods.
+  const PreparedCodeBase* code_;
+  const PreparedMachine* code_machine_;
+  bool bidirectional_search_;
+  CheckTier last_check_tier_;
+  ThreadPool* thread_pool_;
+
+  // Scratch memory. It keeps capacity between checks so repeated calls of
+  // IsBijective() do not allocate memory after first ones.
+  // Prepared copies for checks of not prepared code or state machine.
+  PreparedCode own_code_;
+  PreparedMachine own_machine_;
+  SynonymyStatesMap states_visiting_;
+  std::vector<SynonymyState> syn_states_;
+  SynonymyStatesMap backward_states_visiting_;
+  std::vector<SynonymyState> backward_syn_states_;
+  std::vector<SynonymyState> next_syn_states_;
+  // Per-chunk and per-thread buffers of concurrent search.
+  std::vector<std::vector<SynonymyState> > chunks_syn_states_;
+  std::vector<unsigned> chunks_offsets_;
+  std::vector<std::vector<SynonymyState> > threads_next_syn_states_;
+  SynonymyClaimsTable syn_states_claims_;
 };
 
 #endif  // INCLUDE_BIJECTIVE_CHECKER_H_
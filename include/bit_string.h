@@ -0,0 +1,40 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_BIT_STRING_H_
+#define INCLUDE_BIT_STRING_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Binary word packed by 64 bits per machine word. Bit i is bit (i % 64) of
+// word i / 64 (from least significant bit).
+class BitString {
+ public:
+  BitString();
+
+  // From string of '0' and '1' characters.
+  explicit BitString(const std::string& str);
+
+  // Memory is reused.
+  void Assign(const std::string& str);
+
+  unsigned length() const { return length_; }
+
+  bool GetBit(unsigned pos) const {
+    return (words_[pos >> 6] >> (pos & 63)) & 1;
+  }
+
+  // Returns n_bits (up to 64) bits starting from pos. Bit pos is the least
+  // significant one.
+  uint64_t GetBits(unsigned pos, unsigned n_bits) const;
+
+ private:
+  std::vector<uint64_t> words_;
+  unsigned length_;
+};
+
+#endif  // INCLUDE_BIT_STRING_H_
@@ -0,0 +1,45 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_CODE_AUTOMATON_H_
+#define INCLUDE_CODE_AUTOMATON_H_
+
+#include <vector>
+
+#include "include/code_tree.h"
+
+// Aho-Corasick automaton of code tree. States are nodes of tree. After
+// reading of word automaton is at node of the longest suffix of word which
+// is prefix of some elementary code. All elementary codes which are suffixes
+// of read word are found by output links. Instantiated for the same radices
+// as code tree.
+template<int kRadix>
+class BasicCodeAutomaton {
+ public:
+  void Build(const BasicCodeTree<kRadix>& code_tree);
+
+  int GetNextState(int state, int symbol) const {
+    return next_states_[kRadix * state + symbol];
+  }
+
+  // The longest proper suffix of state which is a node of tree.
+  int GetFailure(int state) const { return failures_[state]; }
+
+  // The longest suffix of state (including state itself) which is a node of
+  // elementary code or -1. Root (empty code) is not an output.
+  int GetOutput(int state) const { return outputs_[state]; }
+
+  unsigned GetDepth(int state) const { return depths_[state]; }
+
+ private:
+  std::vector<int> next_states_;
+  std::vector<int> failures_;
+  std::vector<int> outputs_;
+  std::vector<unsigned> depths_;
+  std::vector<int> queue_;
+};
+
+typedef BasicCodeAutomaton<2> CodeAutomaton;
+
+#endif  // INCLUDE_CODE_AUTOMATON_H_
@@ -5,24 +5,91 @@
 #ifndef INCLUDE_CODE_TREE_H_
 #define INCLUDE_CODE_TREE_H_
 
-#include <string>
 #include <vector>
 
-#include "include/code_tree_node.h"
+#include "include/alphabet.h"
+#include "include/structures.h"
 
-class CodeTree {
+// Tree of elementary codes over alphabet of kRadix symbols. Nodes are kept in
+// single array and refer to children by indices. Elementary codes are sorted
+// in order of depth-first traversal of tree (codes of node are before codes
+// of it's children, children are ordered by symbols), so codes with prefix
+// of some node are range of sorted codes. Instantiated for radices 2, 3, 4
+// and 256.
+template<int kRadix>
+class BasicCodeTree {
  public:
-  explicit CodeTree(const std::vector<ElementaryCode*>& code);
+  typedef typename Alphabet<kRadix>::Word Word;
 
-  ~CodeTree();
+  BasicCodeTree();
 
-  CodeTreeNode* Find(const std::string& code,
-                     std::vector<ElementaryCode*>* upper_elem_codes = 0) const;
+  explicit BasicCodeTree(const std::vector<ElementaryCode*>& code);
+
+  // Rebuilds tree. Memory is reused.
+  void Build(const std::vector<ElementaryCode*>& code);
+
+  void Clear();
+
+  // Returns id of code's node or -1 if there is no such node. Elementary
+  // codes which are prefixes of code (including code itself) are appended to
+  // upper_elem_codes.
+  int Find(const Word& code,
+           std::vector<ElementaryCode*>* upper_elem_codes = 0) const;
+
+  // The same for symbols [pos, pos + length) of code.
+  int Find(const Word& code, unsigned pos, unsigned length,
+           std::vector<ElementaryCode*>* upper_elem_codes = 0) const;
+
+  // Elementary codes in order of depth-first traversal.
+  const std::vector<ElementaryCode*>& GetSortedElemCodes() const;
+
+  // Codes with prefix of node are in range [begin, end) of sorted codes.
+  void GetLowerElemCodes(int node_id, unsigned* begin, unsigned* end) const;
+
+  // The last added elementary code of node or 0.
+  ElementaryCode* GetElemCode(int node_id) const;
+
+  // Root is node with id 0.
+  unsigned GetNumberNodes() const;
+
+  // Returns child id or -1.
+  int GetChild(int node_id, int symbol) const {
+    return nodes_[node_id].childs[symbol];
+  }
 
  private:
-  void Add(const std::vector<ElementaryCode*>& code);
+  struct Node {
+    int childs[kRadix];
+    ElementaryCode* elem_code;
+    // Range at sorted codes.
+    unsigned lower_begin;
+    unsigned n_lower_elem_codes;
+    // List of codes of this node by next_equal_codes_.
+    int first_code;
+    int last_code;
+  };
+
+  int NewNode();
+
+  void Add(ElementaryCode* elem_code, int elem_code_idx);
+
+  void SortElemCodes();
 
-  CodeTreeNode* root_;
+  std::vector<Node> nodes_;
+  std::vector<ElementaryCode*> sorted_elem_codes_;
+
+  // Memory for building.
+  std::vector<int> next_equal_codes_;
+  std::vector<int> stack_;
+  const std::vector<ElementaryCode*>* code_;
 };
 
+// Binary codes are read by 64 bits at once.
+template<>
+int BasicCodeTree<2>::Find(const Word& code, unsigned pos, unsigned length,
+                           std::vector<ElementaryCode*>* upper_elem_codes)
+    const;
+
+typedef BasicCodeTree<2> CodeTree;
+
 #endif  // INCLUDE_CODE_TREE_H_
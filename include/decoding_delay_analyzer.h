@@ -0,0 +1,56 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_DECODING_DELAY_ANALYZER_H_
+#define INCLUDE_DECODING_DELAY_ANALYZER_H_
+
+#include <vector>
+#include <string>
+
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+#include "include/synonymy_graph.h"
+
+// Finds decoding delay of bijective code: how much of encoded stream is read
+// after the last point where all parsings agreed while two different
+// parsings are still possible. Such parsings are not trivial paths of
+// synonymy state machine from states of trivial paths. Delay is unbounded
+// if not trivial states have a loop, otherwise it's the longest path of not
+// trivial states.
+class DecodingDelayAnalyzer {
+ public:
+  // Returns false if delay is unbounded. Otherwise n_elem_codes is the
+  // maximal number of elementary codes of both parsings and n_bits is the
+  // maximal number of bits (symbols for other alphabets) of the longer
+  // parsing since the last point of agreement. Decoder buffer of n_bits
+  // keeps every undecided elementary code.
+  bool Analyze(const PreparedCodeBase& code,
+               const PreparedMachine& code_machine,
+               unsigned* n_elem_codes, unsigned* n_bits);
+
+  bool Analyze(const std::vector<std::string>& code,
+               const StateMachine& code_state_machine,
+               unsigned* n_elem_codes, unsigned* n_bits);
+
+ private:
+  // Length of deficit's suffix.
+  unsigned GetDeficitLength(const PreparedCodeBase& code,
+                            const State* deficit) const;
+
+  SynonymyGraph graph_;
+
+  // Memory for longest paths.
+  std::vector<unsigned> n_in_transitions_;
+  std::vector<int> queue_;
+  // Longest paths by number of codes and by sum of lengths of codes of both
+  // parsings. -1 if state is not reached yet.
+  std::vector<int> n_path_codes_;
+  std::vector<int> n_path_bits_;
+
+  PreparedCode own_code_;
+  PreparedMachine own_machine_;
+};
+
+#endif  // INCLUDE_DECODING_DELAY_ANALYZER_H_
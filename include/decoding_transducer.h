@@ -0,0 +1,144 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_DECODING_TRANSDUCER_H_
+#define INCLUDE_DECODING_TRANSDUCER_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "include/code_tree.h"
+#include "include/decoding_delay_analyzer.h"
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+
+// Deterministic sequential transducer which decodes binary bijective code
+// with bounded decoding delay. It's compiled by subset construction: state of
+// transducer is set of decoder's hypotheses (node of code tree, state of code
+// state machine, decoded but not emitted elementary codes) as StreamDecoder
+// keeps. Transitions by single bits and by bytes are kept by flat arrays with
+// emitted symbols, so decoding is a loop of table lookups. Built transducer
+// is not changed by decoding and may be shared between threads. Bits are
+// read from the least significant one.
+class DecodingTransducer {
+ public:
+  static const int kStartState = 0;
+
+  DecodingTransducer();
+
+  // Returns false if code is not bijective, has empty or equal elementary
+  // codes, has unbounded decoding delay or transducer has more than
+  // max_n_states states.
+  bool Build(const std::vector<std::string>& code,
+             const StateMachine& code_state_machine,
+             unsigned max_n_states = 1u << 16);
+
+  // Builds transducer of code which is already checked: it's bijective,
+  // has no empty or equal elementary codes and has bounded decoding delay.
+  // Code tree is built by elementary codes, has_next_codes is found by
+  // FindNextCodes(). They are used only while building. Returns false if
+  // transducer has more than max_n_states states.
+  bool Build(const CodeTree& code_tree, const PreparedMachine& code_machine,
+             const std::vector<bool>& has_next_codes,
+             unsigned max_n_states = 1u << 16);
+
+  // Flag of hypothesis with node and state (node * number of states +
+  // state) which may decode elementary code which is longer than node and
+  // allowed by state. Other hypotheses are not kept.
+  static void FindNextCodes(const CodeTree& code_tree,
+                            const PreparedMachine& code_machine,
+                            std::vector<bool>* has_next_codes);
+
+  // Decodes n_bits bits of data from state (kStartState for new stream).
+  // Symbols must have space for n_bits + GetMaxNumberPending() symbols.
+  // Returns number of written symbols or -1 if stream is not a prefix of
+  // encoded word.
+  int Push(const uint8_t* data, unsigned n_bits, int* state,
+           int* symbols) const;
+
+  // Writes the rest symbols of stream which ends at state. Returns their
+  // number or -1 if stream is not encoded word.
+  int Finish(int state, int* symbols) const;
+
+  // Decodes the whole stream.
+  int Decode(const uint8_t* data, unsigned n_bits, int* symbols) const;
+
+  unsigned GetNumberStates() const;
+
+  unsigned GetMaxNumberPending() const;
+
+  // Transition by byte. Returns next state or -1. Emitted symbols are in
+  // range [begin, end).
+  int GetByteTransition(int state, uint8_t byte, const int** begin,
+                        const int** end) const {
+    const unsigned idx = state * 256 + byte;
+    *begin = outputs_.data() + byte_output_offsets_[idx];
+    *end = outputs_.data() + byte_output_offsets_[idx + 1];
+    return byte_next_states_[idx];
+  }
+
+ private:
+  struct Hypothesis {
+    int node;
+    int state;
+    std::vector<int> pending;
+  };
+
+  void Clear();
+
+  // Builds states by subset construction and transitions by bits and bytes.
+  bool BuildStates(unsigned max_n_states);
+
+  // Moves set of hypotheses by bit, emits codes which all hypotheses start
+  // from and finds state of the next set. Returns -1 if there are no
+  // hypotheses left.
+  int Step(const std::vector<Hypothesis>& hypotheses, int bit,
+           std::vector<int>* emitted);
+
+  // Order of hypotheses by nodes and states.
+  static bool IsLess(const Hypothesis& first, const Hypothesis& second);
+
+  static bool IsEqual(const Hypothesis& first, const Hypothesis& second);
+
+  // Returns state of set of hypotheses. New state is queued.
+  int GetState(const std::vector<Hypothesis>& hypotheses);
+
+  // Data of code given by strings.
+  PreparedCode own_code_;
+  PreparedMachine own_machine_;
+  DecodingDelayAnalyzer delay_analyzer_;
+  CodeTree own_code_tree_;
+  std::vector<bool> own_has_next_codes_;
+
+  // Code which transducer is built for. Kept only while building.
+  const CodeTree* code_tree_;
+  const PreparedMachine* code_machine_;
+  const std::vector<bool>* has_next_codes_;
+  unsigned n_code_states_;
+
+  // Sets of hypotheses of states ordered by nodes and states of code state
+  // machine. They are kept only while building.
+  std::vector<std::vector<Hypothesis> > states_hypotheses_;
+  std::map<std::vector<int>, int> states_ids_;
+
+  // Transitions by bit: next states (or -1) and emitted symbols in range
+  // [offsets[state * 2 + bit], offsets[state * 2 + bit + 1]) of outputs.
+  std::vector<int> bit_next_states_;
+  std::vector<unsigned> bit_output_offsets_;
+  // The same for transitions by bytes.
+  std::vector<int> byte_next_states_;
+  std::vector<unsigned> byte_output_offsets_;
+  // Symbols of end of stream in range [offsets[state], offsets[state + 1])
+  // if final_states[state].
+  std::vector<bool> final_states_;
+  std::vector<unsigned> final_output_offsets_;
+  std::vector<int> outputs_;
+  unsigned max_n_pending_;
+};
+
+#endif  // INCLUDE_DECODING_TRANSDUCER_H_
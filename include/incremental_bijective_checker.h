@@ -0,0 +1,138 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_INCREMENTAL_BIJECTIVE_CHECKER_H_
+#define INCLUDE_INCREMENTAL_BIJECTIVE_CHECKER_H_
+
+#include <stdint.h>
+
+#include <vector>
+#include <string>
+
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+#include "include/synonymy_states_map.h"
+
+// Session of checks of code and code state machine which are changed by
+// small edits. Synonymy states reached by the last search are kept. Adding
+// of elementary code or transition only adds transitions of synonymy state
+// machine, so search continues from reached states which got new
+// transitions. Removing falls back to full search. Results are the same as
+// results of BijectiveChecker (found words may differ).
+class IncrementalBijectiveChecker {
+ public:
+  IncrementalBijectiveChecker();
+
+  void Init(const std::vector<std::string>& code,
+            const StateMachine& code_state_machine);
+
+  // New elementary code gets the next id. Prepared code is rebuilt from all
+  // codes and all it's deficits transitions are sorted and compared with
+  // previous ones, so adding costs as building of PreparedCode regardless
+  // of the number of touched deficits. Only search is continued.
+  void AddElemCode(const std::string& elem_code);
+
+  // Ids of the next elementary codes are decreased. Transitions by events of
+  // removed code are removed, events of the next codes are decreased too.
+  void RemoveElemCode(int id);
+
+  // The last state is final one, so adding of new states makes full search.
+  void AddTransition(unsigned from_id, unsigned to_id, int event_id);
+
+  // Removes the first transition with these states and event.
+  void RemoveTransition(unsigned from_id, unsigned to_id, int event_id);
+
+  bool IsBijective(std::vector<int>* first_bad_word = 0,
+                   std::vector<int>* second_bad_word = 0);
+
+  // The last check continued previous search.
+  bool IsLastCheckIncremental() const;
+
+  const std::vector<std::string>& GetCode() const;
+
+  const StateMachine& GetCodeStateMachine() const;
+
+ private:
+  struct CodeTransition {
+    unsigned from;
+    unsigned to;
+    int event;
+  };
+
+  // Synonymy state by signed deficit id. Unlike unsigned ids, signed ones are
+  // not changed by adding of elementary codes.
+  struct SynonymyState {
+    int deficit;
+    int upper_state;
+    int lower_state;
+    int parent;
+    int symbol;
+    bool is_tivial;
+  };
+
+  // Transition of deficits state machine by signed ids.
+  struct DeficitTransition {
+    int from;
+    int event;
+    int to;
+
+    bool operator<(const DeficitTransition& other) const;
+  };
+
+  enum VisitingBit { TRIVIAL_VISITED = 1, NONTRIVIAL_VISITED = 2 };
+
+  void BuildCodeStateMachine();
+
+  // Sorted transitions of prepared deficits state machine.
+  void GetDeficitsTransitions(std::vector<DeficitTransition>* transitions);
+
+  // Key of synonymy state which doesn't depend on number of suffixes.
+  uint64_t Key(int deficit, unsigned upper_state, unsigned lower_state) const;
+
+  void StartSearch();
+
+  // Expands states from queue head. Returns true if end state is reached by
+  // nontrivial path.
+  bool ContinueSearch();
+
+  // Forgets kept synonymy states and touched deficits and transitions.
+  void DropSearch();
+
+  // Adds not visited states reachable from this one. Returns true if end
+  // state is reached by nontrivial path.
+  bool Expand(unsigned state_idx);
+
+  // Queues reached states which may have new transitions.
+  void ExpandTouchedStates();
+
+  void ExtractWords(std::vector<int>* first_bad_word,
+                    std::vector<int>* second_bad_word);
+
+  std::vector<std::string> code_;
+  unsigned n_code_sm_states_;
+  std::vector<CodeTransition> code_transitions_;
+  StateMachine code_state_machine_;
+  PreparedCode prepared_code_;
+  PreparedMachine prepared_machine_;
+
+  // Search is valid for current code and state machine with respect to
+  // touched states.
+  bool is_search_valid_;
+  bool is_end_found_;
+  bool is_last_check_incremental_;
+  unsigned head_;
+  SynonymyStatesMap states_visiting_;
+  std::vector<SynonymyState> syn_states_;
+  // Signed ids of deficits and ids of code state machine states which got
+  // new transitions after the last search.
+  std::vector<int> touched_deficits_;
+  std::vector<unsigned> touched_code_sm_states_;
+  std::vector<DeficitTransition> deficits_transitions_;
+  std::vector<DeficitTransition> new_deficits_transitions_;
+  std::vector<bool> is_touched_deficit_;
+  std::vector<bool> is_touched_code_sm_state_;
+};
+
+#endif  // INCLUDE_INCREMENTAL_BIJECTIVE_CHECKER_H_
@@ -0,0 +1,47 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_OBJECT_POOL_H_
+#define INCLUDE_OBJECT_POOL_H_
+
+#include <vector>
+
+// Storage of objects which keeps them between uses. Rewind() makes all
+// objects free in O(1) but doesn't delete them, so next New() calls return
+// already constructed objects and no heap allocation happens while number of
+// used objects doesn't exceed reached maximum. Returned objects keep their
+// previous content (and capacity of containers), caller must reinitialize it.
+template<typename T>
+class ObjectPool {
+ public:
+  ObjectPool() : size_(0) {}
+
+  ~ObjectPool() {
+    for (unsigned i = 0; i < objects_.size(); ++i) {
+      delete objects_[i];
+    }
+  }
+
+  T* New() {
+    if (size_ == objects_.size()) {
+      objects_.push_back(new T());
+    }
+    return objects_[size_++];
+  }
+
+  void Rewind() { size_ = 0; }
+
+  unsigned size() const { return size_; }
+
+  T* operator[](unsigned idx) const { return objects_[idx]; }
+
+ private:
+  ObjectPool(const ObjectPool&);
+  ObjectPool& operator=(const ObjectPool&);
+
+  std::vector<T*> objects_;
+  unsigned size_;
+};
+
+#endif  // INCLUDE_OBJECT_POOL_H_
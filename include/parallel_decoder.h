@@ -0,0 +1,97 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_PARALLEL_DECODER_H_
+#define INCLUDE_PARALLEL_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "include/decoding_transducer.h"
+#include "include/thread_pool.h"
+
+// Decodes stream by several threads. Stream is split to chunks at bytes and
+// every chunk is decoded speculatively from every plausible state of
+// decoding transducer: state which is reached from start state by bytes. It's
+// set of decoder's hypotheses (state of code state machine, read bits of
+// elementary code and pending codes), so it's found by deficits and code
+// state machine which transducer is built from. Runs from different states
+// are merged when they reach the same state at the same byte. Chunk is
+// synchronized when there is single run left, self-synchronizing codes are
+// synchronized after a short prefix. Sequential fix-up pass chooses run of
+// every chunk by end state of the previous one. Chunks which are not
+// synchronized after kMaxSpeculativeBytes bytes are decoded by fix-up pass.
+class ParallelDecoder {
+ public:
+  explicit ParallelDecoder(int n_threads);
+
+  // Transducer must be alive while decoder is used. Returns false if
+  // transducer has too many plausible states, stream is decoded sequentially
+  // then.
+  bool Init(const DecodingTransducer* transducer);
+
+  // Decodes the whole stream as DecodingTransducer::Decode().
+  int Decode(const uint8_t* data, unsigned n_bits, int* symbols);
+
+  // Stream is decoded in parallel.
+  bool IsSpeculative() const;
+
+ private:
+  ParallelDecoder(const ParallelDecoder&);
+  ParallelDecoder& operator=(const ParallelDecoder&);
+
+  // Chunks are at least this number of bytes and up to this number of
+  // chunks per thread for balancing.
+  static const unsigned kMinChunkSize;
+  static const unsigned kNumChunksPerThread;
+  static const unsigned kMaxNumberStarts;
+  static const unsigned kMaxSpeculativeBytes;
+
+  // Decoding of chunk from plausible state with id start_id.
+  struct Run {
+    // State after chunk, -1 if it isn't decoded.
+    int state;
+    std::vector<int> symbols;
+    // Run which this one is merged to after symbols or -1. The next symbols
+    // are symbols of that run from merge_offset.
+    int merged_run;
+    unsigned merge_offset;
+  };
+
+  struct Chunk {
+    // Runs by ids of start states.
+    std::vector<Run> runs;
+    bool is_synchronized;
+  };
+
+  // Range of run's symbols which is copied to position of output.
+  struct Segment {
+    const int* begin;
+    const int* end;
+    unsigned position;
+  };
+
+  // Runs chunk of bytes [begin, end) and n_tail_bits bits after it. The
+  // first chunk is decoded only from start state.
+  void DecodeChunk(const uint8_t* data, unsigned begin, unsigned end,
+                   unsigned n_tail_bits, int thread, Chunk* chunk);
+
+  ThreadPool thread_pool_;
+  const DecodingTransducer* transducer_;
+  // Plausible states and their ids (-1 for other states).
+  std::vector<int> starts_;
+  std::vector<int> starts_ids_;
+  bool is_speculative_;
+
+  std::vector<Chunk> chunks_;
+  std::vector<Segment> segments_;
+  // Per thread: runs which are not merged or stopped and run which has
+  // reached state at the current byte.
+  std::vector<std::vector<int> > threads_runs_;
+  std::vector<std::vector<int> > threads_next_runs_;
+  std::vector<std::vector<int> > threads_states_runs_;
+};
+
+#endif  // INCLUDE_PARALLEL_DECODER_H_
@@ -0,0 +1,72 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_PREFIX_DECODING_TABLE_H_
+#define INCLUDE_PREFIX_DECODING_TABLE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "include/code_tree.h"
+
+// Lookup tables for decoding of binary prefix code by several bits at once.
+// Table of node is indexed by the next bits (the first bit is the least
+// significant one) and gives elementary code and number of it's bits read
+// from node. If there is no code in this number of bits, entry refers to
+// table of node which is reached by all bits of table. Tables are built for
+// root and for nodes reached by tables.
+class PrefixDecodingTable {
+ public:
+  struct Entry {
+    // Id of elementary code, kInvalid if there is no such code or
+    // kNextTable - table_id if it's not complete.
+    int value;
+    unsigned n_bits;
+  };
+
+  static const int kInvalid = -1;
+  static const int kNextTable = -2;
+
+  PrefixDecodingTable();
+
+  // Rebuilds tables of code tree of prefix code. Tables have up to
+  // max_n_bits bits but not more than the longest code from node.
+  void Build(const CodeTree& code_tree, unsigned max_n_bits);
+
+  // Returns id of node's table or -1.
+  int GetTable(int node) const {
+    return node_tables_[node];
+  }
+
+  unsigned GetNumberBits(int table) const {
+    return tables_bits_[table];
+  }
+
+  int GetNode(int table) const {
+    return tables_nodes_[table];
+  }
+
+  const Entry& Lookup(int table, uint64_t bits) const {
+    return entries_[tables_offsets_[table] + bits];
+  }
+
+  // Entries of table indexed by bits.
+  const Entry* GetEntries(int table) const {
+    return &entries_[tables_offsets_[table]];
+  }
+
+ private:
+  int AddTable(int node, unsigned max_n_bits);
+
+  std::vector<Entry> entries_;
+  std::vector<unsigned> tables_offsets_;
+  std::vector<unsigned> tables_bits_;
+  std::vector<int> tables_nodes_;
+  std::vector<int> node_tables_;
+  // Length of the longest code from node.
+  std::vector<unsigned> heights_;
+};
+
+#endif  // INCLUDE_PREFIX_DECODING_TABLE_H_
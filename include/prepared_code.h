@@ -0,0 +1,145 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_PREPARED_CODE_H_
+#define INCLUDE_PREPARED_CODE_H_
+
+#include <vector>
+#include <string>
+#include <utility>
+
+#include "include/state_machine.h"
+#include "include/structures.h"
+#include "include/code_automaton.h"
+#include "include/code_tree.h"
+#include "include/simple_suffix_tree.h"
+#include "include/object_pool.h"
+
+// Everything for bijectivity check which depends only on code: elementary
+// codes, their suffixes and deficits state machine. It's built once and used
+// for checks with many code state machines. Built object is not changed by
+// checks so it may be shared between threads. Deficits state machine doesn't
+// depend on alphabet, so checker uses this base of codes of all alphabets.
+class PreparedCodeBase {
+ public:
+  const std::vector<ElementaryCode*>& GetElemCodes() const;
+
+  // Suffixes of elementary codes. The first one is empty suffix.
+  const std::vector<Suffix*>& GetSuffixes() const;
+
+  const StateMachine& GetDeficitsStateMachine() const;
+
+  // No elementary code is prefix of another one (and there are no equal
+  // codes). Such code is bijective for any code state machine.
+  bool IsPrefixFree() const;
+
+  // No elementary code is suffix of another one.
+  bool IsSuffixFree() const;
+
+  // Finds the first pair of equal elementary codes. Returns false if there
+  // are no equal codes.
+  bool GetDuplicates(int* first_id, int* second_id) const;
+
+  // Sum of radix^(-length) by all elementary codes is more than 1. Such code
+  // is not bijective for code state machine of all words.
+  bool ViolatesMcMillanInequality() const;
+
+  // Number of repeated transitions which were found while building deficits
+  // state machine and were not added.
+  unsigned GetNumberRemovedTransitions() const;
+
+  void WriteDeficitsStateMachine(const std::string& file_path) const;
+
+  // From (-3 -2 -1 0 1 2 3)
+  // To (0 1 2 3 4 5 6 7)
+  unsigned UnsignedDeficitId(int id) const {
+    return id + code_suffixes_.size() - 1;
+  }
+
+  // From (0 1 2 3 4 5 6 7)
+  // To (-3 -2 -1 0 1 2 3)
+  int SignedDeficitId(unsigned id) const {
+    return id - code_suffixes_.size() + 1;
+  }
+
+ protected:
+  PreparedCodeBase();
+
+  // Upper elementary codes of suffixes and lower ranges must be found.
+  void BuildDeficitsStateMachine();
+
+  std::vector<ElementaryCode*> code_;
+  std::vector<Suffix*> code_suffixes_;
+  bool is_prefix_free_;
+  bool is_suffix_free_;
+  int first_duplicate_id_;
+  int second_duplicate_id_;
+  bool violates_mcmillan_inequality_;
+  ObjectPool<ElementaryCode> elem_codes_pool_;
+
+  // Elementary codes which are prefixes of suffix i are in range
+  // [offsets[i], offsets[i + 1]) ordered by length.
+  std::vector<unsigned> upper_elem_codes_offsets_;
+  std::vector<ElementaryCode*> upper_elem_codes_;
+  // Elementary codes with prefix of suffix i are in range
+  // [begin[i], end[i]) of lower_elem_codes.
+  std::vector<ElementaryCode*> lower_elem_codes_;
+  std::vector<unsigned> lower_elem_codes_begins_;
+  std::vector<unsigned> lower_elem_codes_ends_;
+
+ private:
+  PreparedCodeBase(const PreparedCodeBase&);
+  PreparedCodeBase& operator=(const PreparedCodeBase&);
+
+  void AddIsotropicDeficits(int deficit_id,
+                            std::vector<int>* deficits_up_to_build);
+
+  void AddAntitropicDeficits(int deficit_id,
+                             std::vector<int>* deficits_up_to_build);
+
+  // Adds transition if there is no the same one and queues new deficit.
+  void AddDeficitTransition(int from_id, int to_id, int event_id,
+                            std::vector<int>* deficits_up_to_build);
+
+  StateMachine deficits_state_machine_;
+  unsigned n_removed_transitions_;
+
+  // Memory which is kept between builds.
+  std::vector<int> deficits_up_to_build_;
+  std::vector<bool> queued_deficits_;
+  // Id of the last state which has transition by event.
+  std::vector<unsigned> events_stamps_;
+};
+
+// Prepared code over alphabet of kRadix symbols. Instantiated for the same
+// radices as code tree.
+template<int kRadix>
+class BasicPreparedCode : public PreparedCodeBase {
+ public:
+  BasicPreparedCode();
+
+  explicit BasicPreparedCode(const std::vector<std::string>& code);
+
+  // Rebuilds object for another code. Memory is reused.
+  void Build(const std::vector<std::string>& code);
+
+ private:
+  // Finds properties of code which decide bijectivity without building
+  // synonymy states.
+  void CheckCodeProperties();
+
+  // Finds elementary codes which are prefixes of each suffix and elementary
+  // codes with prefix of each suffix by single pass of Aho-Corasick
+  // automaton over elementary codes.
+  void FindSuffixesRelations();
+
+  BasicSimpleSuffixTree<kRadix> suffix_tree_;
+  BasicCodeTree<kRadix> code_tree_;
+  BasicCodeAutomaton<kRadix> code_automaton_;
+  std::vector<std::pair<int, ElementaryCode*> > relations_buffer_;
+};
+
+typedef BasicPreparedCode<2> PreparedCode;
+
+#endif  // INCLUDE_PREPARED_CODE_H_
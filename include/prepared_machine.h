@@ -0,0 +1,73 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_PREPARED_MACHINE_H_
+#define INCLUDE_PREPARED_MACHINE_H_
+
+#include <vector>
+
+#include "include/state_machine.h"
+
+// Transition of prepared machine. State is destination state for outgoing
+// transitions and source state for incoming ones.
+struct PreparedTransition {
+  int state;
+  int event;
+};
+
+// Flat copy of state machine for fast searching of transitions. Only first
+// transition by each event of each state is used (as State::GetTransition()
+// does). For small alphabets next states are kept in dense table indexed by
+// state and event. Otherwise outgoing transitions of each state are sorted
+// by events and found by binary search. Built object is not changed by
+// checks so it may be shared between threads.
+class PreparedMachine {
+ public:
+  PreparedMachine();
+
+  explicit PreparedMachine(const StateMachine& state_machine);
+
+  // Rebuilds object for another state machine. Memory is reused.
+  void Build(const StateMachine& state_machine);
+
+  unsigned GetNumberStates() const;
+
+  // Returns state reached from this one by event or -1.
+  int GetNextState(unsigned state, int event) const {
+    if (is_dense_) {
+      return (static_cast<unsigned>(event) < n_events_ ?
+              dense_next_states_[state * n_events_ + event] : -1);
+    }
+    return FindNextState(state, event);
+  }
+
+  // Transitions to this state.
+  const PreparedTransition* GetInTransitions(unsigned state,
+                                             unsigned* n_transitions) const;
+
+  bool IsDense() const;
+
+  // Machine has single state with loops by all events in range
+  // [0, n_events). So it accepts all words.
+  bool AcceptsAllWords(unsigned n_events) const;
+
+ private:
+  static const unsigned kMaxDenseNumberEvents;
+  static const unsigned kMaxDenseTableSize;
+
+  int FindNextState(unsigned state, int event) const;
+
+  unsigned n_states_;
+  unsigned n_events_;
+  bool is_dense_;
+
+  std::vector<int> dense_next_states_;
+  // Transitions of state i are in range [offsets[i], offsets[i + 1]).
+  std::vector<unsigned> out_offsets_;
+  std::vector<PreparedTransition> out_transitions_;
+  std::vector<unsigned> in_offsets_;
+  std::vector<PreparedTransition> in_transitions_;
+};
+
+#endif  // INCLUDE_PREPARED_MACHINE_H_
@@ -7,23 +7,41 @@
 
 #include <vector>
 
+#include "include/alphabet.h"
 #include "include/structures.h"
-
-class SimpleSuffixTree {
+#include "include/object_pool.h"
+
+// Finds distinct suffixes of elementary codes. Suffixes of each code are
+// ordered from the longest one, ids are given in order of first occurrence.
+// Equal suffixes are the same nodes of tree of reversed elementary codes, so
+// building takes time linear by total length of code. Instantiated for the
+// same radices as code tree.
+template<int kRadix>
+class BasicSimpleSuffixTree {
  public:
   void Build(std::vector<ElementaryCode*>* code);
 
   void GetSuffixes(std::vector<Suffix*>* suffixes);
 
+  // Rewinds tree to empty state. Suffixes are kept for reuse by next Build()
+  // so previously returned suffixes became invalid.
   void Clear();
 
  private:
-  // Index to vertex after corresponding symbol.
-  std::vector<int> childs_[2];
+  Suffix* NewSuffix(int id, int length, ElementaryCode* first_owner = 0);
+
+  ObjectPool<Suffix> suffixes_pool_;
+  // Index to vertex after symbol s of vertex v is childs_[v * kRadix + s].
+  // Vertex at depth d is suffix with length d.
+  std::vector<int> childs_;
   // Suffixes contained in vertices. 0 if simple node.
   std::vector<Suffix*> vertices_content_;
   // All suffixes.
   std::vector<Suffix*> suffixes_;
+  // Vertices of suffixes of current code by lengths.
+  std::vector<int> path_;
 };
 
+typedef BasicSimpleSuffixTree<2> SimpleSuffixTree;
+
 #endif  // INCLUDE_SIMPLE_SUFFIX_TREE_H_
@@ -10,6 +10,7 @@
 #include <map>
 
 #include "include/structures.h"
+#include "include/object_pool.h"
 
 class StateMachine {
  public:
@@ -19,6 +20,8 @@ class StateMachine {
 
   void Init(int n_states);
 
+  // Makes machine empty. States and transitions objects are kept for reuse
+  // by next Init() and AddTransition() calls.
   void Clear();
 
   void AddTransition(unsigned from_id, unsigned to_id, int event_id);
@@ -38,8 +41,8 @@ class StateMachine {
   void WriteConfig(std::ofstream* s) const;
 
  private:
-  std::vector<State*> states_;
-  std::vector<Transition*> transitions_;
+  ObjectPool<State> states_;
+  ObjectPool<Transition> transitions_;
 };
 
 #endif  // INCLUDE_STATE_MACHINE_H_
@@ -0,0 +1,317 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_STATIC_BIJECTIVE_CHECKER_H_
+#define INCLUDE_STATIC_BIJECTIVE_CHECKER_H_
+
+#include <stdint.h>
+
+#include "include/synonymy_step.h"
+
+// Bijectivity check of small binary codes by constant expressions, so
+// it may be used by static_assert. Check makes the same cheap checks and
+// the same search of synonymy loop as BijectiveChecker, but deficits are
+// found while searching. Code state machine is given by transitions
+// {from, to, event}, the first transition of state by event is used and
+// the last state is final one. Code must have up to kMaxTotalLength bits
+// and state machine up to kMaxNumberStates states, otherwise check isn't a
+// constant expression. Only the check is constant expression, decoding
+// tables are built at run time by decoders.
+class StaticBijectiveChecker {
+ public:
+  static const int kMaxTotalLength = 64;
+  static const int kMaxNumberCodes = kMaxTotalLength;
+  static const int kMaxNumberStates = 8;
+
+  template<int kNumCodes, int kNumTransitions>
+  static constexpr bool IsBijective(
+      const char* const (&code)[kNumCodes], int n_states,
+      const int (&transitions)[kNumTransitions][3]) {
+    return IsBijective(code, kNumCodes, n_states, transitions,
+                       kNumTransitions);
+  }
+
+  static constexpr bool IsBijective(const char* const* code, int n_codes,
+                                    int n_states,
+                                    const int (*transitions)[3],
+                                    int n_transitions) {
+    Code prepared_code;
+    Machine machine;
+    if (!Prepare(code, n_codes, n_states, transitions, n_transitions,
+                 &prepared_code, &machine)) {
+      return OutOfLimits();
+    }
+
+    bool accepts_all_words = n_states == 1;
+    for (int i = 0; i < n_codes; ++i) {
+      accepts_all_words = accepts_all_words && machine.next[0][i] == 0;
+    }
+    if (accepts_all_words && HasDuplicates(prepared_code)) {
+      return false;
+    }
+    if (IsPrefixFree(prepared_code) || IsSuffixFree(prepared_code)) {
+      return true;
+    }
+    return !FindSynonymyLoop(prepared_code, machine);
+  }
+
+ private:
+  static const int kMaxNumberDeficits = 2 * kMaxTotalLength + 1;
+  // Keys of states of product and flag of not trivial path. Trivial path to
+  // not identity deficit is defined by state and code which has left
+  // identity deficit, such states have the next keys.
+  static const int kNumberProductKeys =
+      kMaxNumberDeficits * kMaxNumberStates * kMaxNumberStates * 2;
+  static const int kMaxNumberSynStates =
+      kNumberProductKeys + kMaxNumberCodes * kMaxNumberStates;
+
+  // Elementary codes are concatenated, code i is in range
+  // [begins[i], begins[i + 1]) of symbols.
+  struct Code {
+    char symbols[kMaxTotalLength] = {};
+    int begins[kMaxNumberCodes + 1] = {};
+    // End of code of each position.
+    int ends[kMaxTotalLength] = {};
+    int n_codes = 0;
+    // Id of suffix started at position. Empty suffix has id 0.
+    int suffixes[kMaxTotalLength] = {};
+    // The first position of each suffix.
+    int positions[kMaxTotalLength + 1] = {};
+    int n_suffixes = 1;
+  };
+
+  // Next states by events or -1.
+  struct Machine {
+    int next[kMaxNumberStates][kMaxNumberCodes] = {};
+    int n_states = 0;
+  };
+
+  // Not constexpr, so check of code out of limits isn't constant expression.
+  static bool OutOfLimits() { return false; }
+
+  static constexpr bool Prepare(const char* const* code, int n_codes,
+                                int n_states, const int (*transitions)[3],
+                                int n_transitions, Code* prepared_code,
+                                Machine* machine) {
+    if (n_codes > kMaxNumberCodes || n_states > kMaxNumberStates ||
+        n_states < 1) {
+      return false;
+    }
+    int length = 0;
+    prepared_code->n_codes = n_codes;
+    for (int i = 0; i < n_codes; ++i) {
+      prepared_code->begins[i] = length;
+      for (const char* symbol = code[i]; *symbol; ++symbol) {
+        if (length == kMaxTotalLength) {
+          return false;
+        }
+        prepared_code->symbols[length++] = *symbol;
+      }
+      for (int j = prepared_code->begins[i]; j < length; ++j) {
+        prepared_code->ends[j] = length;
+      }
+    }
+    prepared_code->begins[n_codes] = length;
+
+    // Equal suffixes get id of the first one.
+    for (int i = 0; i < length; ++i) {
+      int id = 0;
+      for (int j = 0; j < i && id == 0; ++j) {
+        if (Equals(*prepared_code, i, prepared_code->ends[i], j,
+                   prepared_code->ends[j])) {
+          id = prepared_code->suffixes[j];
+        }
+      }
+      if (id == 0) {
+        id = prepared_code->n_suffixes++;
+        prepared_code->positions[id] = i;
+      }
+      prepared_code->suffixes[i] = id;
+    }
+
+    machine->n_states = n_states;
+    for (int i = 0; i < n_states; ++i) {
+      for (int j = 0; j < n_codes; ++j) {
+        machine->next[i][j] = -1;
+      }
+    }
+    for (int i = 0; i < n_transitions; ++i) {
+      const int from = transitions[i][0];
+      const int to = transitions[i][1];
+      const int event = transitions[i][2];
+      if (from < 0 || from >= n_states || to < 0 || to >= n_states) {
+        return false;
+      }
+      if (event >= 0 && event < n_codes && machine->next[from][event] == -1) {
+        machine->next[from][event] = to;
+      }
+    }
+    return true;
+  }
+
+  // Symbols [begin, end) are equal to [other_begin, other_end).
+  static constexpr bool Equals(const Code& code, int begin, int end,
+                               int other_begin, int other_end) {
+    if (end - begin != other_end - other_begin) {
+      return false;
+    }
+    for (int i = 0; i < end - begin; ++i) {
+      if (code.symbols[begin + i] != code.symbols[other_begin + i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static constexpr int GetLength(const Code& code, int id) {
+    return code.begins[id + 1] - code.begins[id];
+  }
+
+  static constexpr bool HasDuplicates(const Code& code) {
+    for (int i = 0; i < code.n_codes; ++i) {
+      for (int j = 0; j < i; ++j) {
+        if (Equals(code, code.begins[i], code.begins[i + 1], code.begins[j],
+                   code.begins[j + 1])) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  static constexpr bool IsPrefixFree(const Code& code) {
+    for (int i = 0; i < code.n_codes; ++i) {
+      for (int j = 0; j < code.n_codes; ++j) {
+        if (i != j && GetLength(code, i) <= GetLength(code, j) &&
+            Equals(code, code.begins[i], code.begins[i + 1], code.begins[j],
+                   code.begins[j] + GetLength(code, i))) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  static constexpr bool IsSuffixFree(const Code& code) {
+    for (int i = 0; i < code.n_codes; ++i) {
+      for (int j = 0; j < code.n_codes; ++j) {
+        if (i != j && GetLength(code, i) <= GetLength(code, j) &&
+            Equals(code, code.begins[i], code.begins[i + 1],
+                   code.begins[j + 1] - GetLength(code, i),
+                   code.begins[j + 1])) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Deficit is 0 for identity one, 2 * suffix id - 1 if upper word is longer
+  // by suffix and 2 * suffix id if lower word is longer. Returns deficit
+  // after appending of elementary code to shorter word (to lower one for
+  // identity deficit) or -1 if words become different.
+  static constexpr int GetNextDeficit(const Code& code, int deficit,
+                                      int event) {
+    const int suffix_id = (deficit + 1) / 2;
+    const bool upper_is_longer = deficit % 2 == 1;
+    const int position = (suffix_id == 0 ? 0 : code.positions[suffix_id]);
+    const int suffix_length = (suffix_id == 0 ? 0 :
+                               code.ends[position] - position);
+    const int begin = code.begins[event];
+    const int length = GetLength(code, event);
+    if (length <= suffix_length) {
+      // Elementary code is prefix of suffix.
+      if (!Equals(code, position, position + length, begin, begin + length)) {
+        return -1;
+      }
+      if (length == suffix_length) {
+        return 0;
+      }
+      const int next_id = code.suffixes[position + length];
+      return (upper_is_longer ? 2 * next_id - 1 : 2 * next_id);
+    }
+    // Suffix is proper prefix of elementary code.
+    if (!Equals(code, position, position + suffix_length, begin,
+                begin + suffix_length)) {
+      return -1;
+    }
+    const int next_id = code.suffixes[begin + suffix_length];
+    return (deficit == 0 || upper_is_longer ? 2 * next_id : 2 * next_id - 1);
+  }
+
+  // Breadth-first search of not trivial path from start synonymy state to
+  // end one. Synonymy state is (deficit, upper state, lower state, flag of
+  // not trivial path) and code which has left identity deficit for trivial
+  // path to not identity deficit.
+  static constexpr bool FindSynonymyLoop(const Code& code,
+                                         const Machine& machine) {
+    const int n_states = machine.n_states;
+    uint64_t visited[(kMaxNumberSynStates + 63) / 64] = {};
+    int queue[kMaxNumberSynStates] = {};
+    int queue_size = 1;
+    visited[0] = 1;
+    for (int head = 0; head < queue_size; ++head) {
+      int key = queue[head];
+      bool is_nontrivial = false;
+      int leaving_code = -1;
+      int deficit = 0;
+      int upper_state = 0;
+      int lower_state = 0;
+      if (key >= kNumberProductKeys) {
+        key -= kNumberProductKeys;
+        leaving_code = key / kMaxNumberStates;
+        upper_state = key % kMaxNumberStates;
+        lower_state = machine.next[upper_state][leaving_code];
+        deficit = GetNextDeficit(code, 0, leaving_code);
+      } else {
+        is_nontrivial = key % 2;
+        key /= 2;
+        lower_state = key % n_states;
+        key /= n_states;
+        upper_state = key % n_states;
+        deficit = key / n_states;
+      }
+      // Upper word is longer at odd deficits.
+      const bool lower_moves = SynonymyStep::LowerMoves(
+          deficit % 2 == 1 ? deficit : -deficit);
+      for (int event = 0; event < code.n_codes; ++event) {
+        const int next_state = machine.next[lower_moves ? lower_state :
+                                                          upper_state][event];
+        if (next_state == -1) {
+          continue;
+        }
+        const int next_deficit = GetNextDeficit(code, deficit, event);
+        if (next_deficit == -1) {
+          continue;
+        }
+        const int next_upper_state = (lower_moves ? upper_state : next_state);
+        const int next_lower_state = (lower_moves ? next_state : lower_state);
+        const bool next_is_nontrivial = !SynonymyStep::IsTrivial(
+            !is_nontrivial, deficit == 0, next_deficit == 0, event,
+            leaving_code);
+        if (next_is_nontrivial && next_deficit == 0 &&
+            next_upper_state == n_states - 1 &&
+            next_lower_state == n_states - 1) {
+          return true;
+        }
+        int next_key = ((next_deficit * n_states + next_upper_state) *
+                        n_states + next_lower_state) * 2 +
+                       next_is_nontrivial;
+        const int next_leaving_code = SynonymyStep::LeavingCode(
+            !next_is_nontrivial, next_deficit == 0, event);
+        if (next_leaving_code != -1) {
+          next_key = kNumberProductKeys +
+                     next_leaving_code * kMaxNumberStates + upper_state;
+        }
+        if (!((visited[next_key / 64] >> (next_key % 64)) & 1)) {
+          visited[next_key / 64] |= 1ull << (next_key % 64);
+          queue[queue_size++] = next_key;
+        }
+      }
+    }
+    return false;
+  }
+};
+
+#endif  // INCLUDE_STATIC_BIJECTIVE_CHECKER_H_
@@ -0,0 +1,130 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_STREAM_DECODER_H_
+#define INCLUDE_STREAM_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+#include <string>
+
+#include "include/bijective_checker.h"
+#include "include/code_tree.h"
+#include "include/decoding_delay_analyzer.h"
+#include "include/decoding_transducer.h"
+#include "include/prefix_decoding_table.h"
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+
+// Decoder of binary bijective code with bounded decoding delay. Encoded
+// stream is pushed by chunks of bits, bit i of chunk is bit (i % 8) of byte
+// i / 8 (from least significant bit). Decoder keeps set of hypotheses: node
+// of code tree (read bits of the current elementary code), state of code
+// state machine and elementary codes decoded since the last point where all
+// hypotheses agreed. Hypothesis is kept only if the current elementary code
+// may be allowed by state. Hypotheses with the same node and state have the
+// same future, so only one of them is kept. Elementary code is emitted when all
+// hypotheses start from it. Number of kept codes is bounded by decoding delay
+// and all memory is allocated by Init(). Prefix codes have single hypothesis,
+// they are decoded by lookup tables without hypotheses. Other codes are
+// decoded by bytes with DecodingTransducer if it's not too large. Otherwise
+// hypotheses are moved bit by bit, which is an order of magnitude slower.
+class StreamDecoder {
+ public:
+  StreamDecoder();
+
+  // Returns false if code is not bijective, has empty or equal elementary
+  // codes or has unbounded decoding delay. Transducer is used if it has up to
+  // max_n_transducer_states states (256 transitions by bytes each).
+  bool Init(const std::vector<std::string>& code,
+            const StateMachine& code_state_machine,
+            unsigned max_n_transducer_states = 1u << 10);
+
+  // Starts new stream.
+  void Reset();
+
+  // Decodes n_bits bits of data. Decoded symbols (ids of elementary codes)
+  // are written to symbols which must have space for
+  // n_bits + GetMaxNumberPending() symbols. Returns number of written symbols
+  // or -1 if stream is not a prefix of encoded word. Decoder must be reset
+  // after error.
+  int Push(const uint8_t* data, unsigned n_bits, int* symbols);
+
+  // Ends stream and writes the rest symbols (up to GetMaxNumberPending()).
+  // Returns their number or -1 if stream is not encoded word (stream must end
+  // at final state of code state machine). Decoder is reset.
+  int Finish(int* symbols);
+
+  // Maximal number of decoded but not emitted symbols.
+  unsigned GetMaxNumberPending() const;
+
+  // Code is prefix one and it's decoded by lookup tables.
+  bool IsTableDriven() const;
+
+  // Code is decoded by transitions of DecodingTransducer.
+  bool IsTransducerDriven() const;
+
+ private:
+  // Maximal number of bits of lookup table.
+  static const unsigned kMaxTableBits;
+
+  // Decoding of prefix code. Hypothesis is kept by nodes[0] and states[0].
+  int PushByTables(const uint8_t* data, unsigned n_bits, int* symbols);
+
+  // Moves hypotheses by bit. Returns false if there are no hypotheses left.
+  bool Step(int bit);
+
+  // Adds hypothesis which continues hypothesis idx of current ones. code_id
+  // is -1 if no elementary code is decoded by step.
+  void AddHypothesis(int node, int state, int idx, int code_id);
+
+  // Emits codes which all hypotheses start from.
+  int Commit(int* symbols);
+
+  PreparedCode prepared_code_;
+  PreparedMachine prepared_machine_;
+  BijectiveChecker checker_;
+  DecodingDelayAnalyzer delay_analyzer_;
+  CodeTree code_tree_;
+
+  // Code tree by flat arrays: children of node i are childs[2 * i] and
+  // childs[2 * i + 1], node_codes[i] is id of elementary code or -1.
+  std::vector<int> childs_;
+  std::vector<int> node_codes_;
+  unsigned n_states_;
+  // Hypothesis with node and state may decode elementary code which is
+  // longer than node and allowed by state. Otherwise hypothesis is not kept,
+  // so decoded codes are bounded by decoding delay.
+  std::vector<bool> has_next_codes_;
+  unsigned max_n_pending_;
+  PrefixDecodingTable prefix_table_;
+  bool is_table_driven_;
+  // State is not changed by any code, so it's not tracked by tables.
+  bool accepts_all_words_;
+  DecodingTransducer transducer_;
+  bool is_transducer_driven_;
+  int transducer_state_;
+
+  // Current and next hypotheses. Pending codes of hypothesis i are in range
+  // [i * max_n_pending, i * max_n_pending + n_pending[i]).
+  std::vector<int> nodes_;
+  std::vector<int> states_;
+  std::vector<unsigned> n_pending_;
+  std::vector<int> pending_;
+  unsigned n_hypotheses_;
+  std::vector<int> next_nodes_;
+  std::vector<int> next_states_;
+  std::vector<unsigned> next_n_pending_;
+  std::vector<int> next_pending_;
+  unsigned n_next_hypotheses_;
+
+  // Stamp of step which added hypothesis with node and state.
+  std::vector<unsigned> stamps_;
+  unsigned stamp_;
+  bool is_failed_;
+};
+
+#endif  // INCLUDE_STREAM_DECODER_H_
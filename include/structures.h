@@ -10,12 +10,18 @@
 #include <string>
 #include <vector>
 
+#include "include/bit_string.h"
+
 struct Suffix;
 struct ElementaryCode {
   int id;
   std::string str;
+  // Packed str of binary code. Empty for other alphabets.
+  BitString bits;
   std::vector<Suffix*> suffixes;
 
+  ElementaryCode() : id(0) {}
+
   ElementaryCode(int id, const std::string& str);
 };
 
@@ -24,8 +30,15 @@ struct Suffix {
   int length;
   std::vector<ElementaryCode*> owners;
 
+  Suffix() : id(0), length(0) {}
+
   Suffix(int id, int length, ElementaryCode* first_owner = 0);
 
+  // Position of suffix at the first owner.
+  unsigned offset() const {
+    return owners[0]->str.size() - length;
+  }
+
   std::string str();
 };
 
@@ -33,6 +46,9 @@ struct Transition;
 struct State {
   unsigned id;
   std::vector<Transition*> transitions;  // Transitions from this state.
+  std::vector<Transition*> in_transitions;  // Transitions to this state.
+
+  State() : id(0) {}
 
   explicit State(unsigned id) : id(id) {}
 
@@ -46,6 +62,8 @@ struct Transition {
   State* to;
   int event_id;
 
+  Transition() : id(0), from(0), to(0), event_id(0) {}
+
   Transition(unsigned id, State* from, State* to, int event_id);
 };
 
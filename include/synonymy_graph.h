@@ -0,0 +1,77 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_SYNONYMY_GRAPH_H_
+#define INCLUDE_SYNONYMY_GRAPH_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+#include "include/synonymy_states_map.h"
+
+// Reachable part of synonymy state machine with flags of trivial paths (see
+// SynonymyStep) for analyses which need the whole graph. Trivial states at
+// not identity deficit are distinguished by code which has left identity
+// deficit, so every path of graph has a single trivial flag. Nodes are
+// numbered in order of breadth-first search from start one and edges of
+// every node are kept together in flat array.
+class SynonymyGraph {
+ public:
+  struct Node {
+    State* deficit;
+    int upper_state;
+    int lower_state;
+    // Code which has left identity deficit by trivial path or -1.
+    int leaving_code;
+    bool is_tivial;
+  };
+
+  struct Edge {
+    int to;
+    // Positive (code id + 1) for upper word, negative (-code id - 1) for
+    // lower one.
+    int symbol;
+  };
+
+  SynonymyGraph();
+
+  // Memory is reused.
+  void Build(const PreparedCodeBase& code, const PreparedMachine& code_machine);
+
+  unsigned GetNumberNodes() const;
+
+  const Node& GetNode(int id) const;
+
+  // Edges from node.
+  const Edge* GetEdges(int id, unsigned* n_edges) const;
+
+  // Node of identity deficit and final states of code state machine reached
+  // by not trivial path or -1.
+  int GetEndNode() const;
+
+  // Removes edges from and to nodes which can't reach end node. is_useful
+  // flags nodes which can reach it.
+  void RemoveUselessNodes(std::vector<bool>* is_useful);
+
+ private:
+  // Index of node for SynonymyStatesIndex. Trivial node at not identity
+  // deficit is defined by leaving code and state of upper word.
+  uint64_t Key(const Node& node) const;
+
+  unsigned n_deficits_;
+  unsigned n_code_sm_states_;
+  unsigned identity_deficit_id_;
+  std::vector<Node> nodes_;
+  // Edges of node i are in range [offsets[i], offsets[i + 1]).
+  std::vector<unsigned> offsets_;
+  std::vector<Edge> edges_;
+  int end_node_;
+  SynonymyStatesIndex nodes_ids_;
+};
+
+#endif  // INCLUDE_SYNONYMY_GRAPH_H_
@@ -0,0 +1,117 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_SYNONYMY_STATES_MAP_H_
+#define INCLUDE_SYNONYMY_STATES_MAP_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+// Map from 64-bit index of synonymy state (state of product of deficits
+// state machine and two code state machines) to small value in range [0, 3].
+// Values of all states are 0 initially. If number of states is small, values
+// are kept in dense table by 2 bits per state. Otherwise only states with
+// nonzero values are kept in open addressing hash table, so memory depends on
+// number of reached states, not on number of all states.
+class SynonymyStatesMap {
+ public:
+  SynonymyStatesMap();
+
+  // Makes all values zero. Memory is kept for reuse.
+  void Init(uint64_t n_states);
+
+  unsigned char Get(uint64_t state) const;
+
+  void Set(uint64_t state, unsigned char value);
+
+  bool IsDense() const;
+
+  // Makes sure that n_new_states states can be added by SetBitsConcurrently()
+  // without rehashing.
+  void Reserve(unsigned n_new_states);
+
+  // Sets bits of value of state. It may be called from several threads
+  // simultaneously if there are no concurrent calls of other methods.
+  void SetBitsConcurrently(uint64_t state, unsigned char bits);
+
+ private:
+  static const uint64_t kMaxDenseNumberStates;
+  static const unsigned kInitialHashCapacity;
+  static const uint64_t kEmptyKey;
+
+  // Returns index of slot with this key or empty slot where it should be.
+  unsigned FindSlot(uint64_t state) const;
+
+  void Rehash(unsigned capacity);
+
+  bool is_dense_;
+
+  // Dense table. 32 states per word.
+  std::vector<uint64_t> dense_values_;
+
+  // Hash table. Capacity is power of 2, load factor is less than 0.5.
+  std::vector<uint64_t> keys_;
+  std::vector<unsigned char> values_;
+  unsigned n_keys_;
+  std::vector<uint64_t> old_keys_;
+  std::vector<unsigned char> old_values_;
+};
+
+// Map from 64-bit index of synonymy state to id of reached state, -1 for
+// states which are not reached. Ids are kept by dense table if number of
+// states is small, otherwise reached states are kept in open addressing hash
+// table as by SynonymyStatesMap.
+class SynonymyStatesIndex {
+ public:
+  SynonymyStatesIndex();
+
+  // Makes all ids -1. Memory is kept for reuse.
+  void Init(uint64_t n_states);
+
+  int Get(uint64_t state) const;
+
+  // Id must be not negative.
+  void Set(uint64_t state, int id);
+
+ private:
+  static const uint64_t kMaxDenseNumberStates;
+  static const unsigned kInitialHashCapacity;
+  static const uint64_t kEmptyKey;
+
+  // Returns index of slot with this key or empty slot where it should be.
+  unsigned FindSlot(uint64_t state) const;
+
+  void Rehash(unsigned capacity);
+
+  bool is_dense_;
+  std::vector<int> dense_ids_;
+  std::vector<uint64_t> keys_;
+  std::vector<int> ids_;
+  unsigned n_keys_;
+  std::vector<uint64_t> old_keys_;
+  std::vector<int> old_ids_;
+};
+
+// Table for choosing single one from several candidates of the same
+// synonymy state found concurrently. Every candidate claims its rank and the
+// minimal rank wins. Two kinds of claims (for trivial and not trivial paths)
+// are kept for each state.
+class SynonymyClaimsTable {
+ public:
+  // Makes table empty. It would keep up to n_states states.
+  void Init(unsigned n_states);
+
+  // Thread safe.
+  void Claim(uint64_t state, int kind, unsigned rank);
+
+  // Minimal claimed rank.
+  unsigned GetRank(uint64_t state, int kind) const;
+
+ private:
+  std::vector<uint64_t> keys_;
+  std::vector<unsigned> ranks_;
+};
+
+#endif  // INCLUDE_SYNONYMY_STATES_MAP_H_
@@ -0,0 +1,51 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_SYNONYMY_STEP_H_
+#define INCLUDE_SYNONYMY_STEP_H_
+
+// Rules of step of synonymy state machine which are shared by all searches
+// over it. Synonymy state is a deficit and states of code state machine of
+// upper and lower words. Elementary code is appended to the shorter word (to
+// the lower one at identity deficit). Path is trivial while both words read
+// the same elementary codes: lower word leaves identity deficit by code and
+// upper word returns to it by the same code. Equal elementary codes are
+// different codes. Backward search applies the same rules to reversed
+// transitions: deficit of the step is the later one.
+class SynonymyStep {
+ public:
+  // Signed deficit is positive if upper word is longer.
+  static constexpr bool LowerMoves(int signed_deficit) {
+    return signed_deficit >= 0;
+  }
+
+  // Positive (code id + 1) for upper word, negative (-code id - 1) for lower
+  // one.
+  static constexpr int Symbol(bool lower_moves, int code_id) {
+    return (lower_moves ? -code_id - 1 : code_id + 1);
+  }
+
+  static constexpr int CodeId(int symbol) {
+    return (symbol > 0 ? symbol : -symbol) - 1;
+  }
+
+  // Path stays trivial by step from deficit to the next one by code.
+  // leaving_code is code which has left identity deficit by trivial path
+  // (any value at identity deficit).
+  static constexpr bool IsTrivial(bool is_trivial, bool is_identity,
+                                  bool next_is_identity, int code_id,
+                                  int leaving_code) {
+    return is_trivial &&
+           (is_identity || (next_is_identity && code_id == leaving_code));
+  }
+
+  // Code which has left identity deficit by trivial path to the next state
+  // or -1.
+  static constexpr int LeavingCode(bool next_is_trivial,
+                                   bool next_is_identity, int code_id) {
+    return (next_is_trivial && !next_is_identity ? code_id : -1);
+  }
+};
+
+#endif  // INCLUDE_SYNONYMY_STEP_H_
@@ -0,0 +1,62 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_THREAD_POOL_H_
+#define INCLUDE_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed number of threads which process groups of tasks. Thread called Run()
+// works as thread with id 0, so n_threads - 1 threads are created. Tasks are
+// split between threads by equal ranges. Thread which has finished it's range
+// steals half of remaining tasks from the most loaded thread, so tasks of
+// different cost are balanced.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int n_threads);
+
+  ~ThreadPool();
+
+  int GetNumberThreads() const;
+
+  // Calls task(task_id, thread_id) for every task_id in [0, n_tasks) and
+  // waits all of them. Thread id is in [0, number of threads) so it can be
+  // used as index of per-thread data.
+  void Run(int n_tasks, const std::function<void(int, int)>& task);
+
+ private:
+  void WorkerLoop(int thread_id);
+
+  void RunTasks(int thread_id);
+
+  // Moves half of tasks of the most loaded thread to this one. Returns false
+  // if there are no tasks.
+  bool StealTasks(int thread_id);
+
+  // Range of tasks [begin, end) of single thread. Owner takes tasks from
+  // the begin, thieves take them from the end.
+  struct TasksRange {
+    std::mutex mutex;
+    int begin;
+    int end;
+  };
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_cv_;
+  std::condition_variable done_cv_;
+  // Incremented at every Run() to wake up workers.
+  unsigned generation_;
+  int n_busy_workers_;
+  bool stop_;
+
+  const std::function<void(int, int)>* task_;
+  std::vector<TasksRange> ranges_;
+};
+
+#endif  // INCLUDE_THREAD_POOL_H_
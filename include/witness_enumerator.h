@@ -0,0 +1,63 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#ifndef INCLUDE_WITNESS_ENUMERATOR_H_
+#define INCLUDE_WITNESS_ENUMERATOR_H_
+
+#include <vector>
+
+#include "include/prepared_code.h"
+#include "include/prepared_machine.h"
+#include "include/synonymy_graph.h"
+
+// Enumerates pairs of different words with the same encoding (witnesses of
+// not bijective code) in order of non-decreasing total number of elementary
+// codes. Witnesses are paths of synonymy state machine from start state to
+// end one by not trivial path. Reachable part of synonymy state machine is
+// built once and kept between calls, states which can't reach end state by
+// not trivial path are removed. Then paths are extended by breadth-first
+// search, so every extended path gives witness. Every witness is returned
+// once: the first word is lexicographically less than the second one and
+// mirrored pair is skipped.
+class WitnessEnumerator {
+ public:
+  WitnessEnumerator();
+
+  // Code and state machine must be alive while witnesses are enumerated.
+  // Init is not lazy: it builds the whole reachable synonymy state machine
+  // (see SynonymyGraph), up to 2 * number of deficits * (number of code
+  // state machine states)^2 states as BijectiveChecker's full search does
+  // and number of codes * number of code state machine states trivial ones.
+  // Only Next() is lazy.
+  void Init(const PreparedCodeBase& code, const PreparedMachine& code_machine);
+
+  // Returns false if there are no more witnesses. There are infinitely many
+  // witnesses if there is at least one of them and code state machine has
+  // loops.
+  bool Next(std::vector<int>* first_word, std::vector<int>* second_word);
+
+  // Number of useful states of synonymy state machine.
+  unsigned GetNumberStates() const;
+
+ private:
+  // Path of breadth-first search. Paths are kept as tree by parent links.
+  struct Path {
+    int state;
+    int parent;
+    int symbol;
+  };
+
+  void ExtractWords(int path_idx, std::vector<int>* first_word,
+                    std::vector<int>* second_word);
+
+  const PreparedCodeBase* code_;
+  const PreparedMachine* code_machine_;
+  SynonymyGraph graph_;
+  std::vector<bool> is_useful_;
+  // Queue of breadth-first search.
+  std::vector<Path> paths_;
+  unsigned head_;
+};
+
+#endif  // INCLUDE_WITNESS_ENUMERATOR_H_
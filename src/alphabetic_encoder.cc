@@ -7,6 +7,7 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <queue>
 #include <fstream>
 #include <string>
@@ -14,7 +15,14 @@
 #include <iostream>
 #include <sstream>
 
-AlphabeticEncoder::AlphabeticEncoder(const std::string& config_file) {
+const unsigned AlphabeticEncoder::kMaxNextStatesTableSize = 1u << 24;
+const unsigned AlphabeticEncoder::kMaxWordBits = 56;
+const unsigned AlphabeticEncoder::kMinChunkSize = 1u << 14;
+const unsigned AlphabeticEncoder::kNumChunksPerThread = 4;
+const unsigned AlphabeticEncoder::kMaxNumberTrackedStates = 8;
+
+AlphabeticEncoder::AlphabeticEncoder(const std::string& config_file)
+  : thread_pool_(0) {
   // File format:
   // [int] alphabet size
   // [string] alphabet encoding
@@ -49,12 +57,306 @@ AlphabeticEncoder::AlphabeticEncoder(const std::string& config_file) {
     file >> character_id;
     state_machine_.AddTransition(from_id, to_id, character_id);
   }
+  PrepareEncoding();
+}
+
+AlphabeticEncoder::AlphabeticEncoder(const std::vector<std::string>& code,
+                                     const StateMachine& state_machine)
+  : elem_codes_(code), thread_pool_(0) {
+  // Transitions are copied in the same order, so the same ones are used.
+  const int n_states = state_machine.GetNumberStates();
+  state_machine_.Init(n_states);
+  for (int i = 0; i < n_states; ++i) {
+    const std::vector<Transition*>& transitions =
+        state_machine.GetState(i)->transitions;
+    for (unsigned j = 0; j < transitions.size(); ++j) {
+      state_machine_.AddTransition(i, transitions[j]->to->id,
+                                   transitions[j]->event_id);
+    }
+  }
+  PrepareEncoding();
+}
+
+AlphabeticEncoder::~AlphabeticEncoder() {
+  delete thread_pool_;
+}
+
+void AlphabeticEncoder::PrepareEncoding() {
+  const unsigned n_codes = elem_codes_.size();
+  codes_words_.clear();
+  codes_offsets_.assign(1, 0);
+  codes_lengths_.resize(n_codes);
+  for (unsigned i = 0; i < n_codes; ++i) {
+    const std::string& elem_code = elem_codes_[i];
+    codes_lengths_[i] = elem_code.size();
+    for (unsigned j = 0; j < elem_code.size(); ++j) {
+      if (j % kMaxWordBits == 0) {
+        codes_words_.push_back(0);
+      }
+      codes_words_.back() |= static_cast<uint64_t>(elem_code[j] == '1') <<
+                             (j % kMaxWordBits);
+    }
+    codes_offsets_.push_back(codes_words_.size());
+  }
+  prepared_machine_.Build(state_machine_);
+  accepts_all_words_ = prepared_machine_.AcceptsAllWords(n_codes);
+
+  // Dense table of next states for any alphabet while it's not too large.
+  const uint64_t table_size =
+      static_cast<uint64_t>(prepared_machine_.GetNumberStates()) * n_codes;
+  next_states_.clear();
+  if (!accepts_all_words_ && table_size <= kMaxNextStatesTableSize) {
+    next_states_.resize(table_size);
+    for (unsigned i = 0; i < prepared_machine_.GetNumberStates(); ++i) {
+      for (unsigned j = 0; j < n_codes; ++j) {
+        next_states_[i * n_codes + j] = prepared_machine_.GetNextState(i, j);
+      }
+    }
+  }
 }
 
 bool AlphabeticEncoder::CheckBijective() {
   return bijective_checker.IsBijective(elem_codes_, state_machine_);
 }
 
+bool AlphabeticEncoder::Encode(const int* symbols, unsigned n_symbols,
+                               std::vector<uint8_t>* data,
+                               uint64_t* n_bits) const {
+  if (thread_pool_ != 0 && n_symbols >= 2 * kMinChunkSize) {
+    return EncodeConcurrently(symbols, n_symbols, data, n_bits);
+  }
+  const unsigned n_codes = elem_codes_.size();
+  const int final_state = prepared_machine_.GetNumberStates() - 1;
+  // Bytes are written by pointer which may alias anything, so tables are
+  // kept by local pointers.
+  const uint64_t* codes_words = codes_words_.data();
+  const unsigned* codes_offsets = codes_offsets_.data();
+  const unsigned* codes_lengths = codes_lengths_.data();
+  const int* next_states = (next_states_.empty() ? 0 : next_states_.data());
+  const bool accepts_all_words = accepts_all_words_;
+  if (data->size() < 8) {
+    data->resize(8);
+  }
+  uint8_t* bytes = data->data();
+  uint64_t n_bytes = data->size();
+
+  uint64_t buffer = 0;
+  unsigned n_buffered = 0;
+  uint64_t n_written_bytes = 0;
+  int state = 0;
+  for (unsigned i = 0; i < n_symbols; ++i) {
+    const unsigned symbol = symbols[i];
+    if (symbol >= n_codes) {
+      return false;
+    }
+    if (!accepts_all_words) {
+      state = (next_states ? next_states[state * n_codes + symbol] :
+                             prepared_machine_.GetNextState(state, symbol));
+      if (state == -1) {
+        return false;
+      }
+    }
+    // Buffer keeps less than 8 bits between words, so word of up to
+    // kMaxWordBits bits fits it. Buffer is written by 8 bytes, but only
+    // full bytes are counted.
+    unsigned length = codes_lengths[symbol];
+    for (unsigned j = codes_offsets[symbol]; length != 0; ++j) {
+      const unsigned n_word_bits = std::min(length, kMaxWordBits);
+      length -= n_word_bits;
+      buffer |= codes_words[j] << n_buffered;
+      n_buffered += n_word_bits;
+      if (n_written_bytes + 8 > n_bytes) {
+        data->resize(n_bytes * 2);
+        bytes = data->data();
+        n_bytes = data->size();
+      }
+      for (int k = 0; k < 8; ++k) {
+        bytes[n_written_bytes + k] = buffer >> (8 * k);
+      }
+      const unsigned n_full_bytes = n_buffered >> 3;
+      n_written_bytes += n_full_bytes;
+      buffer >>= n_full_bytes * 8;
+      n_buffered &= 7;
+    }
+  }
+  if (!accepts_all_words && state != final_state) {
+    return false;
+  }
+  *n_bits = n_written_bytes * 8 + n_buffered;
+  data->resize(n_written_bytes + (n_buffered + 7) / 8);
+  for (unsigned k = 0; k < (n_buffered + 7) / 8; ++k) {
+    (*data)[n_written_bytes + k] = buffer >> (8 * k);
+  }
+  return true;
+}
+
+void AlphabeticEncoder::SetNumberThreads(int n_threads) {
+  delete thread_pool_;
+  thread_pool_ = (n_threads > 1 ? new ThreadPool(n_threads) : 0);
+}
+
+bool AlphabeticEncoder::EncodeConcurrently(const int* symbols,
+                                           unsigned n_symbols,
+                                           std::vector<uint8_t>* data,
+                                           uint64_t* n_bits) const {
+  const unsigned n_codes = elem_codes_.size();
+  const unsigned n_states = prepared_machine_.GetNumberStates();
+  const int final_state = n_states - 1;
+  const unsigned n_threads = thread_pool_->GetNumberThreads();
+  const unsigned n_chunks = std::max(1u, std::min(n_threads *
+                                                  kNumChunksPerThread,
+                                                  n_symbols / kMinChunkSize));
+  const bool is_tracked = !accepts_all_words_ &&
+                          n_states <= kMaxNumberTrackedStates;
+  std::vector<unsigned> chunks_offsets(n_chunks + 1);
+  for (unsigned i = 0; i <= n_chunks; ++i) {
+    chunks_offsets[i] = static_cast<uint64_t>(n_symbols) * i / n_chunks;
+  }
+
+  // Number of bits of every chunk. Chunk's end state is found for every start
+  // state of code state machine, -1 if it's not recognized.
+  std::vector<uint64_t> chunks_bits(n_chunks + 1, 0);
+  std::vector<int> chunks_states(is_tracked ? n_chunks * n_states : 0);
+  std::vector<int> is_valid(n_chunks, 1);
+  thread_pool_->Run(n_chunks, [&](int chunk, int) {
+    const unsigned* codes_lengths = codes_lengths_.data();
+    const unsigned begin = chunks_offsets[chunk];
+    const unsigned end = chunks_offsets[chunk + 1];
+    uint64_t n_chunk_bits = 0;
+    for (unsigned i = begin; i < end; ++i) {
+      const unsigned symbol = symbols[i];
+      if (symbol >= n_codes) {
+        is_valid[chunk] = 0;
+        return;
+      }
+      n_chunk_bits += codes_lengths[symbol];
+    }
+    chunks_bits[chunk] = n_chunk_bits;
+    if (!is_tracked) {
+      return;
+    }
+    int* states = &chunks_states[chunk * n_states];
+    for (unsigned i = 0; i < n_states; ++i) {
+      int state = i;
+      for (unsigned j = begin; j < end && state != -1; ++j) {
+        state = (next_states_.empty() ?
+                 prepared_machine_.GetNextState(state, symbols[j]) :
+                 next_states_[state * n_codes + symbols[j]]);
+      }
+      states[i] = state;
+    }
+  });
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    if (!is_valid[i]) {
+      return false;
+    }
+  }
+  if (!accepts_all_words_) {
+    int state = 0;
+    if (is_tracked) {
+      for (unsigned i = 0; i < n_chunks && state != -1; ++i) {
+        state = chunks_states[i * n_states + state];
+      }
+    } else {
+      for (unsigned i = 0; i < n_symbols && state != -1; ++i) {
+        state = (next_states_.empty() ?
+                 prepared_machine_.GetNextState(state, symbols[i]) :
+                 next_states_[state * n_codes + symbols[i]]);
+      }
+    }
+    if (state != final_state) {
+      return false;
+    }
+  }
+
+  // Exclusive prefix sum gives bit offsets of chunks.
+  uint64_t n_total_bits = 0;
+  for (unsigned i = 0; i <= n_chunks; ++i) {
+    const uint64_t n_chunk_bits = chunks_bits[i];
+    chunks_bits[i] = n_total_bits;
+    n_total_bits += n_chunk_bits;
+  }
+  data->resize((n_total_bits + 7) / 8);
+  uint8_t* bytes = data->data();
+  std::vector<uint8_t> heads(n_chunks, 0);
+  std::vector<uint8_t> tails(n_chunks, 0);
+  thread_pool_->Run(n_chunks, [&](int chunk, int) {
+    const unsigned begin = chunks_offsets[chunk];
+    EncodeChunk(symbols + begin, chunks_offsets[chunk + 1] - begin,
+                chunks_bits[chunk], bytes, &heads[chunk], &tails[chunk]);
+  });
+
+  // Bytes which are shared by chunks are merged.
+  for (unsigned i = 0; i <= n_chunks; ++i) {
+    if (chunks_bits[i] % 8 != 0) {
+      bytes[chunks_bits[i] / 8] = 0;
+    }
+  }
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    const uint64_t begin = chunks_bits[i];
+    const uint64_t end = chunks_bits[i + 1];
+    if (begin % 8 != 0 && begin / 8 != end / 8) {
+      bytes[begin / 8] |= heads[i];
+    }
+    if (end % 8 != 0) {
+      bytes[end / 8] |= tails[i];
+    }
+  }
+  *n_bits = n_total_bits;
+  return true;
+}
+
+void AlphabeticEncoder::EncodeChunk(const int* symbols, unsigned n_symbols,
+                                    uint64_t bit_offset, uint8_t* bytes,
+                                    uint8_t* head, uint8_t* tail) const {
+  const uint64_t* codes_words = codes_words_.data();
+  const unsigned* codes_offsets = codes_offsets_.data();
+  const unsigned* codes_lengths = codes_lengths_.data();
+  uint64_t n_chunk_bits = 0;
+  for (unsigned i = 0; i < n_symbols; ++i) {
+    n_chunk_bits += codes_lengths[symbols[i]];
+  }
+  // Bytes [begin, end) are covered by chunk.
+  const uint64_t begin = (bit_offset + 7) / 8;
+  const uint64_t end = (bit_offset + n_chunk_bits) / 8;
+
+  // The same packing as at Encode() but buffer starts from unaligned bit.
+  uint64_t buffer = 0;
+  unsigned n_buffered = bit_offset % 8;
+  uint64_t n_written_bytes = bit_offset / 8;
+  *head = 0;
+  for (unsigned i = 0; i < n_symbols; ++i) {
+    const unsigned symbol = symbols[i];
+    unsigned length = codes_lengths[symbol];
+    for (unsigned j = codes_offsets[symbol]; length != 0; ++j) {
+      const unsigned n_word_bits = std::min(length, kMaxWordBits);
+      length -= n_word_bits;
+      buffer |= codes_words[j] << n_buffered;
+      n_buffered += n_word_bits;
+      const unsigned n_full_bytes = n_buffered >> 3;
+      if (n_written_bytes >= begin && n_written_bytes + 8 <= end) {
+        for (int k = 0; k < 8; ++k) {
+          bytes[n_written_bytes + k] = buffer >> (8 * k);
+        }
+      } else {
+        // Near the edges only full bytes are written. The first one is
+        // shared with the previous chunk if it's not covered.
+        for (unsigned k = 0; k < n_full_bytes; ++k) {
+          if (n_written_bytes + k < begin) {
+            *head = buffer >> (8 * k);
+          } else {
+            bytes[n_written_bytes + k] = buffer >> (8 * k);
+          }
+        }
+      }
+      n_written_bytes += n_full_bytes;
+      buffer >>= n_full_bytes * 8;
+      n_buffered &= 7;
+    }
+  }
+  *tail = buffer;
+}
+
 void AlphabeticEncoder::WriteCodeStateMachine(
     const std::string& file_path) const {
   WriteCodeStateMachine(file_path, elem_codes_, state_machine_);
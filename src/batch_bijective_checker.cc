@@ -0,0 +1,80 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/batch_bijective_checker.h"
+
+BijectivityProblem::BijectivityProblem()
+  : code(0),
+    prepared_code(0),
+    code_state_machine(0) {
+}
+
+BijectivityProblem::BijectivityProblem(const std::vector<std::string>* code,
+                                       const StateMachine* code_state_machine)
+  : code(code),
+    prepared_code(0),
+    code_state_machine(code_state_machine) {
+}
+
+BijectivityProblem::BijectivityProblem(const PreparedCodeBase* prepared_code,
+                                       const StateMachine* code_state_machine)
+  : code(0),
+    prepared_code(prepared_code),
+    code_state_machine(code_state_machine) {
+}
+
+BatchBijectiveChecker::BatchBijectiveChecker(int n_threads)
+  : thread_pool_(n_threads) {
+  checkers_.resize(thread_pool_.GetNumberThreads());
+  for (unsigned i = 0; i < checkers_.size(); ++i) {
+    checkers_[i] = new BijectiveChecker();
+  }
+}
+
+BatchBijectiveChecker::~BatchBijectiveChecker() {
+  for (unsigned i = 0; i < checkers_.size(); ++i) {
+    delete checkers_[i];
+  }
+}
+
+void BatchBijectiveChecker::IsBijective(
+    const BijectivityProblem* problems, unsigned n_problems,
+    bool extract_words, std::vector<BijectivityResult>* results) {
+  results->resize(n_problems);
+  thread_pool_.Run(n_problems, [&](int problem_id, int thread_id) {
+    const BijectivityProblem& problem = problems[problem_id];
+    BijectivityResult& result = results->operator[](problem_id);
+    BijectiveChecker* checker = checkers_[thread_id];
+    std::vector<int>* first_bad_word = 0;
+    std::vector<int>* second_bad_word = 0;
+    if (extract_words) {
+      first_bad_word = &result.first_bad_word;
+      second_bad_word = &result.second_bad_word;
+    } else {
+      result.first_bad_word.clear();
+      result.second_bad_word.clear();
+    }
+    if (problem.prepared_code != 0) {
+      result.is_bijective = checker->IsBijective(*problem.prepared_code,
+                                                 *problem.code_state_machine,
+                                                 first_bad_word,
+                                                 second_bad_word);
+    } else {
+      result.is_bijective = checker->IsBijective(*problem.code,
+                                                 *problem.code_state_machine,
+                                                 first_bad_word,
+                                                 second_bad_word);
+    }
+  });
+}
+
+void BatchBijectiveChecker::IsBijective(
+    const std::vector<BijectivityProblem>& problems, bool extract_words,
+    std::vector<BijectivityResult>* results) {
+  if (problems.empty()) {
+    results->clear();
+    return;
+  }
+  IsBijective(&problems[0], problems.size(), extract_words, results);
+}
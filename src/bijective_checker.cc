@@ -6,463 +6,678 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
 #include <iostream>
 #include <algorithm>
 #include <sstream>
+#include <map>
 
 #include "include/simple_suffix_tree.h"
 #include "include/alphabetic_encoder.h"
+#include "include/synonymy_step.h"
 
 bool BijectiveChecker::IsBijective(const std::vector<std::string>& code,
                                    const StateMachine& code_state_machine,
                                    std::vector<int>* first_bad_word,
                                    std::vector<int>* second_bad_word) {
+  own_code_.Build(code);
+  own_machine_.Build(code_state_machine);
+  return IsBijective(own_code_, own_machine_, first_bad_word,
+                     second_bad_word);
+}
+
+bool BijectiveChecker::IsBijective(const PreparedCodeBase& code,
+                                   const StateMachine& code_state_machine,
+                                   std::vector<int>* first_bad_word,
+                                   std::vector<int>* second_bad_word) {
+  own_machine_.Build(code_state_machine);
+  return IsBijective(code, own_machine_, first_bad_word, second_bad_word);
+}
+
+bool BijectiveChecker::IsBijective(const PreparedCodeBase& code,
+                                   const PreparedMachine& code_machine,
+                                   std::vector<int>* first_bad_word,
+                                   std::vector<int>* second_bad_word) {
   Reset();
-  code_state_machine_ = &code_state_machine;
+  code_ = &code;
+  code_machine_ = &code_machine;
 
   if (first_bad_word) first_bad_word->clear();
   if (second_bad_word) second_bad_word->clear();
 
-  code_.resize(code.size());
-  for (int i = 0; i < code.size(); ++i) {
-    code_[i] = new ElementaryCode(i, code[i]);
+  const bool accepts_all_words =
+      code_machine.AcceptsAllWords(code.GetElemCodes().size());
+  int first_duplicate_id, second_duplicate_id;
+  if (accepts_all_words &&
+      code.GetDuplicates(&first_duplicate_id, &second_duplicate_id)) {
+    last_check_tier_ = DUPLICATES_TIER;
+    if (first_bad_word != 0 && second_bad_word != 0) {
+      first_bad_word->push_back(first_duplicate_id);
+      second_bad_word->push_back(second_duplicate_id);
+    }
+    return false;
+  }
+  if (code.IsPrefixFree()) {
+    last_check_tier_ = PREFIX_FREE_TIER;
+    return true;
+  }
+  if (code.IsSuffixFree()) {
+    last_check_tier_ = SUFFIX_FREE_TIER;
+    return true;
+  }
+  // Search is needed to find words anyway.
+  if (accepts_all_words && (first_bad_word == 0 || second_bad_word == 0) &&
+      code.ViolatesMcMillanInequality()) {
+    last_check_tier_ = MCMILLAN_TIER;
+    return false;
   }
 
-  // Select all suffixes.
-  SimpleSuffixTree sst;
-  sst.Build(&code_);
-  sst.GetSuffixes(&code_suffixes_);  // Includes empty suffix.
-
-  // Build code tree.
-  CodeTree code_tree(code_);
-
-  BuildDeficitsStateMachine(code_tree);
-
+  last_check_tier_ = SYNONYMY_LOOP_TIER;
+  // Backward trivial states which return to identity by different equal
+  // codes are not distinguished by visiting, so such codes are checked by
+  // forward search.
+  if (bidirectional_search_ &&
+      !code.GetDuplicates(&first_duplicate_id, &second_duplicate_id)) {
+    return !FindSynonymyLoopBidirectional(first_bad_word, second_bad_word);
+  }
   return !FindSynonymyLoop(first_bad_word, second_bad_word);
 }
 
 BijectiveChecker::~BijectiveChecker() {
   Reset();
+  delete thread_pool_;
 }
 
 unsigned BijectiveChecker::UnsignedDeficitId(int id) {
-  return id + code_suffixes_.size() - 1;
+  return code_->UnsignedDeficitId(id);
 }
 
 int BijectiveChecker::SignedDeficitId(unsigned id) {
-  return id - code_suffixes_.size() + 1;
-}
-
-void BijectiveChecker::BuildDeficitsStateMachine(const CodeTree& code_tree) {
-  // Let 0 state idx - identity deficit,
-  //   i<0 state idx - lower deficit lambda/alpha,
-  //                   where lambda is empty word,
-  //                   alpha - suffix with index |i|
-  //   i>0 state idx - upper deficit alpha/lambda,
-  //                   alpha index is |i|
-  const int n_deficits = code_suffixes_.size() * 2 - 1;
-  deficits_state_machine_ = new StateMachine(n_deficits);
-  const int identity_deficit_id = UnsignedDeficitId(0);
-
-  // Build deficits machine.
-  std::queue<int> deficits_up_to_build;
-  for (int i = 0; i < code_.size(); ++i) {
-    // Suffixes in descending order:
-    // for elementary code 01011
-    // [0]: 01011
-    // [1]: 1011
-    // ...
-    // [4]: 1
-    // [5]: empty suffix
-    int deficit_id = -code_[i]->suffixes[0]->id;
-
-    deficits_state_machine_->AddTransition(identity_deficit_id,
-                                           UnsignedDeficitId(deficit_id), i);
-    deficits_up_to_build.push(deficit_id);
-  }
-
-  std::vector<bool> processed_deficits(n_deficits, false);
-
-  // Identity deficit already processed.
-  processed_deficits[identity_deficit_id] = true;
-
-  // Inductive building.
-  while (!deficits_up_to_build.empty()) {
-    const int deficit_id = deficits_up_to_build.front();
-    const unsigned u_deficit_id = UnsignedDeficitId(deficit_id);
-    deficits_up_to_build.pop();
-    if (!processed_deficits[u_deficit_id]) {
-      AddAntitropicDeficits(deficit_id, code_tree, &deficits_up_to_build);
-      AddIsotropicDeficits(deficit_id, code_tree, &deficits_up_to_build);
-      processed_deficits[u_deficit_id] = true;
-    }
-  }
-}
-
-void BijectiveChecker::AddIsotropicDeficits(
-  int deficit_id,
-  const CodeTree& code_tree,
-  std::queue<int>* deficits_up_to_build) {
-  // Alpha = elem_code + beta.
-  // Find all elementary codes which are preffixes of alpha.
-  Suffix* alpha_suffix = code_suffixes_[abs(deficit_id)];
-  std::vector<ElementaryCode*> upper_elem_codes;
-  code_tree.Find(alpha_suffix->str(), &upper_elem_codes);
-
-  const unsigned size = upper_elem_codes.size();
-  for (unsigned i = 0; i < size; ++i) {
-    int beta_suffix_idx = alpha_suffix->owners[0]->str.length() -
-                          alpha_suffix->length +
-                          upper_elem_codes[i]->str.length();
-    Suffix* beta_suffix = alpha_suffix->owners[0]->suffixes[beta_suffix_idx];
-    int state_id = (deficit_id < 0 ? -beta_suffix->id : beta_suffix->id);
-    deficits_state_machine_->AddTransition(UnsignedDeficitId(deficit_id),
-                                           UnsignedDeficitId(state_id),
-                                           upper_elem_codes[i]->id);
-    deficits_up_to_build->push(state_id);
-  }
-}
-
-void BijectiveChecker::AddAntitropicDeficits(
-    int deficit_id,
-    const CodeTree& code_tree,
-    std::queue<int>* deficits_up_to_build) {
-  // Elem_code = alpha + beta.
-  // Find all elementary codes with prefix [alpha].
-  Suffix* alpha_suffix = code_suffixes_[abs(deficit_id)];
-  CodeTreeNode* alpha_suffix_node = code_tree.Find(alpha_suffix->str());
-  if (alpha_suffix_node) {
-    std::vector<ElementaryCode*> lower_elem_codes;
-    alpha_suffix_node->GetLowerElemCodes(&lower_elem_codes);
-
-    const unsigned size = lower_elem_codes.size();
-    for (int i = 0; i < size; ++i) {
-      // Suffixes ordered from largest to minimal.
-      Suffix* beta_suffix = lower_elem_codes[i]->suffixes[alpha_suffix->length];
-
-      // Let identity deficit is an isotropic deficit.
-      if (beta_suffix->id != 0) {
-        int state_id = (deficit_id < 0 ? beta_suffix->id : -beta_suffix->id);
-        deficits_state_machine_->AddTransition(UnsignedDeficitId(deficit_id),
-                                               UnsignedDeficitId(state_id),
-                                               lower_elem_codes[i]->id);
-        deficits_up_to_build->push(state_id);
-      }
-    }
-  }
+  return code_->SignedDeficitId(id);
 }
 
 BijectiveChecker::BijectiveChecker()
-  : deficits_state_machine_(0),
-    synonymy_state_machine_(0) {
+  : code_(0),
+    code_machine_(0),
+    bidirectional_search_(false),
+    last_check_tier_(SYNONYMY_LOOP_TIER),
+    thread_pool_(0) {
 }
 
 void BijectiveChecker::Reset() {
-  for (int i = 0; i < code_.size(); ++i) {
-    delete code_[i];
-  }
-  code_.clear();
-
-  for (int i = 0; i < code_suffixes_.size(); ++i) {
-    delete code_suffixes_[i];
-  }
-  code_suffixes_.clear();
-
-  delete deficits_state_machine_;
-  deficits_state_machine_ = 0;
-  delete synonymy_state_machine_;
-  synonymy_state_machine_ = 0;
-  code_state_machine_ = 0;
+  synonymy_state_machine_.Clear();
+  code_machine_ = 0;
 }
 
-void BijectiveChecker::WriteDeficitsStateMachine(const std::string& file_path) {
-  // Set states names.
-  const int n_states = deficits_state_machine_->GetNumberStates();
-  std::vector<std::string> states_names(n_states);
-  states_names[UnsignedDeficitId(0)] = "\"\u03bb/\u03bb\"";
-
-  // First suffix if empty suffix, starts from 1.
-  for (int i = 1; i < code_suffixes_.size(); ++i) {
-    std::string str = code_suffixes_[i]->str();
-    states_names[UnsignedDeficitId(i)] = "\"" + str + "/\u03bb\"";
-    states_names[UnsignedDeficitId(-i)] = "\"\u03bb/" + str + "\"";
+bool BijectiveChecker::WriteDeficitsStateMachine(const std::string& file_path) {
+  if (code_ == 0) {
+    return false;
   }
-
-  // Set transitions names.
-  std::map<int, std::string> events_names;
-  const int n_codes = code_.size();
-  for (int i = 0; i < n_codes; ++i) {
-    events_names[i] = code_[i]->str;
-  }
-  deficits_state_machine_->WriteDot(file_path, states_names, events_names);
+  code_->WriteDeficitsStateMachine(file_path);
+  return true;
 }
 
-void BijectiveChecker::WriteSynonymyStateMachine(const std::string& file_path) {
-  const unsigned kNumCodeSmStates = code_state_machine_->GetNumberStates();
-  const unsigned kNumDefsSmStates = deficits_state_machine_->GetNumberStates();
-  const unsigned kNumSuffixes = code_suffixes_.size();
+bool BijectiveChecker::WriteSynonymyStateMachine(const std::string& file_path) {
+  if (code_ == 0 || code_machine_ == 0) {
+    return false;
+  }
+  const unsigned kNumCodeSmStates = code_machine_->GetNumberStates();
+  const unsigned kNumDefsSmStates =
+      code_->GetDeficitsStateMachine().GetNumberStates();
+  const std::vector<Suffix*>& suffixes = code_->GetSuffixes();
+  const int kNumSuffixes = suffixes.size();
 
   // Deficits names.
   std::vector<std::string> deficits_names(kNumDefsSmStates);
   deficits_names[UnsignedDeficitId(0)] = "\u03bb/\u03bb";
   for (int i = 1; i < kNumSuffixes; ++i) {
-    std::string str = code_suffixes_[i]->str();
+    std::string str = suffixes[i]->str();
     deficits_names[UnsignedDeficitId(i)] = str + "/\u03bb";
     deficits_names[UnsignedDeficitId(-i)] = "\u03bb/" + str;
   }
 
   // Code state machine states names.
   std::vector<std::string> code_sm_states_names(kNumCodeSmStates);
-  for (int i = 0; i < kNumCodeSmStates; ++i) {
+  for (unsigned i = 0; i < kNumCodeSmStates; ++i) {
     std::ostringstream ss;
     ss << 'q' << i;
     code_sm_states_names[i] = ss.str();
   }
 
-  std::vector<std::string> states_names(kNumDefsSmStates * kNumCodeSmStates *
-                                        kNumCodeSmStates);
-  unsigned idx = 0;
-  for (unsigned i = 0; i < kNumDefsSmStates; ++i) {
-    for (unsigned j = 0; j < kNumCodeSmStates; ++j) {
-      for (unsigned k = 0; k < kNumCodeSmStates; ++k) {
-        states_names[idx++] = "\"(" + deficits_names[i] + ", " +
-                              code_sm_states_names[j] + "/" +
-                              code_sm_states_names[k] + ")\"";
-      }
-    }
+  // Synonymy state machine contains only reachable states.
+  if (synonymy_state_machine_.GetNumberStates() == 0) {
+    BuildSynonymyStateMachine();
+  }
+  const unsigned kNumSynonymyStates = syn_states_.size();
+  std::vector<std::string> states_names(kNumSynonymyStates);
+  for (unsigned i = 0; i < kNumSynonymyStates; ++i) {
+    const SynonymyState& syn_state = syn_states_[i];
+    states_names[i] = "\"(" + deficits_names[syn_state.deficit->id] + ", " +
+                      code_sm_states_names[syn_state.upper_state] + "/" +
+                      code_sm_states_names[syn_state.lower_state] + ")\"";
   }
 
   // Set transitions names.
   std::map<int, std::string> events_names;
-  const int n_codes = code_.size();
+  const std::vector<ElementaryCode*>& code = code_->GetElemCodes();
+  const int n_codes = code.size();
   for (int i = 0; i < n_codes; ++i) {
-    events_names[i + 1] = code_[i]->str;
-    events_names[-i - 1] = code_[i]->str;
+    events_names[i + 1] = code[i]->str;
+    events_names[-i - 1] = code[i]->str;
   }
-  if (!synonymy_state_machine_) BuildSynonymyStateMachine();
-  synonymy_state_machine_->WriteDot(file_path, states_names, events_names);
+  synonymy_state_machine_.WriteDot(file_path, states_names, events_names);
+  return true;
 }
 
 void BijectiveChecker::BuildSynonymyStateMachine() {
-  const unsigned kNumCodeSmStates = code_state_machine_->GetNumberStates();
-  const unsigned kNumDefsSmStates = deficits_state_machine_->GetNumberStates();
-  const unsigned kNumSynonymyStates = kNumCodeSmStates * kNumCodeSmStates *
-                                      kNumDefsSmStates;
-
-  synonymy_state_machine_ = new StateMachine(kNumSynonymyStates);
-
-  bool state_is_processed[kNumSynonymyStates];
-  memset(state_is_processed, false, kNumSynonymyStates);
+  const unsigned kNumCodeSmStates = code_machine_->GetNumberStates();
+
+  // Reached states are numbered in order of reaching. Their ids are mapped
+  // from 64-bit hashes, so number of states of product doesn't matter.
+  std::map<uint64_t, int> states_ids;
+  std::vector<SynonymyState>& syn_states = syn_states_;
+  syn_states.clear();
+
+  // Transitions are collected until number of states is known.
+  struct SynonymyTransition {
+    int from_id;
+    int to_id;
+    int event_id;
+  };
+  std::vector<SynonymyTransition> transitions;
 
   SynonymyState syn_state;
-  syn_state.deficit = deficits_state_machine_->GetState(UnsignedDeficitId(0));
-  syn_state.upper_state = code_state_machine_->GetState(0);
-  syn_state.lower_state = syn_state.upper_state;
-  state_is_processed[syn_state.Hash(kNumCodeSmStates)] = true;
-
-  std::queue<SynonymyState> syn_states;
-  syn_states.push(syn_state);
+  syn_state.deficit =
+      code_->GetDeficitsStateMachine().GetState(UnsignedDeficitId(0));
+  syn_state.upper_state = 0;
+  syn_state.lower_state = 0;
+  states_ids[syn_state.Hash(kNumCodeSmStates)] = 0;
+  syn_states.push_back(syn_state);
 
   SynonymyState next_syn_state;
-  do {
-    syn_state = syn_states.front();
-    syn_states.pop();
-
-    const unsigned hash_from = syn_state.Hash(kNumCodeSmStates);
+  for (unsigned head = 0; head < syn_states.size(); ++head) {
+    syn_state = syn_states[head];
 
     State* deficit = syn_state.deficit;
-    if (SignedDeficitId(deficit->id) >= 0) {  // event: empty/char
-      for (int i = 0; i < deficit->transitions.size(); ++i) {
-        Transition* def_trans = deficit->transitions[i];
-        const int event = def_trans->event_id;
-
-        Transition* code_trans = syn_state.lower_state->GetTransition(event);
-        if (code_trans != 0) {
-          next_syn_state.deficit = def_trans->to;
-          next_syn_state.upper_state = syn_state.upper_state;
-          next_syn_state.lower_state = code_trans->to;
-          const unsigned hash_to = next_syn_state.Hash(kNumCodeSmStates);
-          synonymy_state_machine_->AddTransition(hash_from, hash_to,
-                                                 -event - 1);
-          if (!state_is_processed[hash_to]) {
-            syn_states.push(next_syn_state);
-            state_is_processed[hash_to] = true;
-          }
+    const bool lower_moves =
+        SynonymyStep::LowerMoves(SignedDeficitId(deficit->id));
+    for (unsigned i = 0; i < deficit->transitions.size(); ++i) {
+      Transition* def_trans = deficit->transitions[i];
+      const int event = def_trans->event_id;
+
+      next_syn_state = syn_state;
+      next_syn_state.deficit = def_trans->to;
+      SynonymyTransition trans;
+      if (lower_moves) {  // event: empty/char
+        const int to = code_machine_->GetNextState(syn_state.lower_state,
+                                                   event);
+        if (to == -1) {
+          continue;
         }
-      }
-    } else {  // event: char/empty
-      for (int i = 0; i < deficit->transitions.size(); ++i) {
-        Transition* def_trans = deficit->transitions[i];
-        const int event = def_trans->event_id;
-
-        Transition* code_trans = syn_state.upper_state->GetTransition(event);
-        if (code_trans != 0) {
-          next_syn_state.deficit = def_trans->to;
-          next_syn_state.upper_state = code_trans->to;
-          next_syn_state.lower_state = syn_state.lower_state;
-          const unsigned hash_to = next_syn_state.Hash(kNumCodeSmStates);
-          synonymy_state_machine_->AddTransition(hash_from, hash_to, event + 1);
-          if (!state_is_processed[hash_to]) {
-            syn_states.push(next_syn_state);
-            state_is_processed[hash_to] = true;
-          }
+        next_syn_state.lower_state = to;
+        trans.event_id = SynonymyStep::Symbol(lower_moves, event);
+      } else {  // event: char/empty
+        const int to = code_machine_->GetNextState(syn_state.upper_state,
+                                                   event);
+        if (to == -1) {
+          continue;
         }
+        next_syn_state.upper_state = to;
+        trans.event_id = SynonymyStep::Symbol(lower_moves, event);
+      }
+
+      const uint64_t hash_to = next_syn_state.Hash(kNumCodeSmStates);
+      std::map<uint64_t, int>::iterator it = states_ids.find(hash_to);
+      if (it == states_ids.end()) {
+        it = states_ids.insert(std::make_pair(hash_to,
+                                              syn_states.size())).first;
+        syn_states.push_back(next_syn_state);
       }
+      trans.from_id = head;
+      trans.to_id = it->second;
+      transitions.push_back(trans);
     }
-  } while (!syn_states.empty());
+  }
+
+  synonymy_state_machine_.Init(syn_states.size());
+  for (unsigned i = 0; i < transitions.size(); ++i) {
+    synonymy_state_machine_.AddTransition(transitions[i].from_id,
+                                          transitions[i].to_id,
+                                          transitions[i].event_id);
+  }
 }
 
 bool BijectiveChecker::FindSynonymyLoop(std::vector<int>* first_bad_word,
                                         std::vector<int>* second_bad_word) {
+  // Levels smaller than this are processed by single thread.
+  static const unsigned kMinConcurrentLevelSize = 1024;
+
   const unsigned kStartDefId = UnsignedDeficitId(0);
-  const unsigned kNumDefSmStates = deficits_state_machine_->GetNumberStates();
-  const unsigned kNumCodeSmStates = code_state_machine_->GetNumberStates();
-  const unsigned kStartSynHash =
-      SynonymyState::Hash(kStartDefId, 0, 0, kNumCodeSmStates);
-  const unsigned kEndSynHash =
+  const unsigned kNumDefSmStates =
+      code_->GetDeficitsStateMachine().GetNumberStates();
+  const unsigned kNumCodeSmStates = code_machine_->GetNumberStates();
+  const uint64_t kEndSynHash =
       SynonymyState::Hash(kStartDefId, kNumCodeSmStates - 1,
                           kNumCodeSmStates - 1, kNumCodeSmStates);
-  const unsigned kMaxNumSynStates = kNumDefSmStates * kNumCodeSmStates *
-                                    kNumCodeSmStates;
+  const uint64_t kMaxNumSynStates = static_cast<uint64_t>(kNumDefSmStates) *
+                                    kNumCodeSmStates * kNumCodeSmStates;
+
+  SynonymyStatesMap& states_visiting = states_visiting_;
+  states_visiting.Init(kMaxNumSynStates);
+
+  // Vector is used as queue. States of current level are in range
+  // [level_begin, level_end).
+  std::vector<SynonymyState>& states = syn_states_;
+  states.clear();
+
+  SynonymyState start_state;
+  start_state.deficit =
+      code_->GetDeficitsStateMachine().GetState(kStartDefId);
+  start_state.upper_state = 0;
+  start_state.lower_state = 0;
+  start_state.parent = -1;
+  start_state.symbol = 0;
+  start_state.is_tivial = true;
+  states.push_back(start_state);
+  states_visiting.Set(start_state.Hash(kNumCodeSmStates), TRIVIAL_VISITED);
+
+  std::vector<SynonymyState>& next_states = next_syn_states_;
+  unsigned level_begin = 0;
+  while (level_begin != states.size()) {
+    const unsigned level_end = states.size();
+    if (thread_pool_ != 0 &&
+        level_end - level_begin >= kMinConcurrentLevelSize) {
+      const int chunk = ProcessLevelConcurrently(level_begin, level_end,
+                                                 kEndSynHash);
+      if (chunk != -1) {
+        // Found state is the last one of chunk.
+        if (first_bad_word != 0 && second_bad_word != 0) {
+          states.push_back(chunks_syn_states_[chunk].back());
+          AppendSynonymyWords(states, states.size() - 1, true,
+                              first_bad_word, second_bad_word);
+        }
+        return true;
+      }
+      level_begin = level_end;
+      continue;
+    }
 
-  // Three visiting states for each state:
-  enum VisitingState { FREE, FREE_FOR_NONTRIVIAL, BUSY };
-  VisitingState* states_visiting = new VisitingState[kMaxNumSynStates];
-  memset(states_visiting, FREE, sizeof(VisitingState) * kMaxNumSynStates);
+    for (unsigned i = level_begin; i < level_end; ++i) {
+      GetNextSynonymyStates(states[i], &next_states);
+      for (unsigned j = 0; j < next_states.size(); ++j) {
+        SynonymyState& next_state = next_states[j];
+        next_state.parent = i;
 
-  SynonymyState syn_state;
-  SynonymyState next_syn_state;
-  std::queue<SynonymyState> states;
+        const uint64_t to_hash = next_state.Hash(kNumCodeSmStates);
+        if (to_hash == kEndSynHash && !next_state.is_tivial) {
+          // Extract not bijective words.
+          if (first_bad_word != 0 && second_bad_word != 0) {
+            states.push_back(next_state);
+            AppendSynonymyWords(states, states.size() - 1, true,
+                                first_bad_word, second_bad_word);
+          }
+          return true;
+        }
 
-  // Fill single character sequences.
-  State* deficit  = deficits_state_machine_->GetState(kStartDefId);
-  syn_state.upper_state = code_state_machine_->GetState(0);
-  syn_state.is_tivial = true;
-  unsigned size = deficit->transitions.size();
-  for (unsigned i = 0; i < size; ++i) {
-    Transition* trans = deficit->transitions[i];
-    Transition* code_sm_trans = syn_state.upper_state
-                                ->GetTransition(trans->event_id);
-    if (code_sm_trans != 0) {
-      syn_state.deficit = trans->to;
-      syn_state.lower_state = code_sm_trans->to;
-      syn_state.sequence = new int[1];
-      syn_state.sequence[0] = -trans->event_id - 1;
-      states.push(syn_state);
+        const unsigned char bit = (next_state.is_tivial ? TRIVIAL_VISITED :
+                                                          NONTRIVIAL_VISITED);
+        const unsigned char vis_state = states_visiting.Get(to_hash);
+        if ((vis_state & bit) == 0) {
+          states_visiting.Set(to_hash, vis_state | bit);
+          states.push_back(next_state);
+        }
+      }
     }
+    level_begin = level_end;
   }
+  return false;
+}
 
-  unsigned sequnce_length = 1;
-  while (!states.empty()) {
-    size = states.size();
-    for (unsigned i = 0; i < size; ++i) {
-      syn_state = states.front();
-      deficit = syn_state.deficit;
-      const unsigned n_trans = deficit->transitions.size();
-      for (int j = 0; j < n_trans; ++j) {
-        Transition* trans = deficit->transitions[j];
-        const int event = trans->event_id;
-
-        // Check next state to existing.
-        next_syn_state = syn_state;
-        next_syn_state.deficit = trans->to;
-        trans = (SignedDeficitId(deficit->id) >= 0 ?
-                   syn_state.lower_state->GetTransition(event) :
-                   syn_state.upper_state->GetTransition(event));
-        int new_char;
-
-        if (trans != 0) {
-          if (SignedDeficitId(deficit->id) >= 0) {
-            next_syn_state.lower_state = trans->to;
-            new_char = -event - 1;
-          } else {
-            next_syn_state.upper_state = trans->to;
-            new_char = event + 1;
-          }
+int BijectiveChecker::ProcessLevelConcurrently(unsigned level_begin,
+                                               unsigned level_end,
+                                               uint64_t end_syn_hash) {
+  // Number of chunks per thread for balancing.
+  static const unsigned kNumChunksPerThread = 8;
+  static const unsigned kMinChunkSize = 128;
+
+  const unsigned kNumCodeSmStates = code_machine_->GetNumberStates();
+  const unsigned n_threads = thread_pool_->GetNumberThreads();
+  const unsigned level_size = level_end - level_begin;
+  const unsigned n_chunks = std::max(1u, std::min(n_threads *
+                                                  kNumChunksPerThread,
+                                                  level_size / kMinChunkSize));
+  std::vector<SynonymyState>& states = syn_states_;
+  SynonymyStatesMap& states_visiting = states_visiting_;
+  SynonymyClaimsTable& claims = syn_states_claims_;
+  if (chunks_syn_states_.size() < n_chunks) {
+    chunks_syn_states_.resize(n_chunks);
+  }
+  threads_next_syn_states_.resize(n_threads);
+  chunks_offsets_.resize(n_chunks + 1);
+
+  // Generate candidates of next level. Only states visited at previous levels
+  // are filtered out here, visiting map is not changed. Chunk processing stops
+  // at end state so it is the last one at chunk.
+  std::vector<int> end_found(n_chunks, 0);
+  thread_pool_->Run(n_chunks, [&](int chunk, int thread) {
+    std::vector<SynonymyState>& candidates = chunks_syn_states_[chunk];
+    std::vector<SynonymyState>& next_states = threads_next_syn_states_[thread];
+    candidates.clear();
+    const unsigned begin = level_begin +
+                           static_cast<uint64_t>(level_size) * chunk / n_chunks;
+    const unsigned end = level_begin +
+                         static_cast<uint64_t>(level_size) * (chunk + 1) /
+                         n_chunks;
+    for (unsigned i = begin; i < end; ++i) {
+      GetNextSynonymyStates(states[i], &next_states);
+      for (unsigned j = 0; j < next_states.size(); ++j) {
+        SynonymyState& next_state = next_states[j];
+        next_state.parent = i;
+        const uint64_t to_hash = next_state.Hash(kNumCodeSmStates);
+        if (to_hash == end_syn_hash && !next_state.is_tivial) {
+          candidates.push_back(next_state);
+          end_found[chunk] = 1;
+          return;
         }
-        else {
-          continue;  // Transition not exists.
+        const unsigned char bit = (next_state.is_tivial ? TRIVIAL_VISITED :
+                                                          NONTRIVIAL_VISITED);
+        if ((states_visiting.Get(to_hash) & bit) == 0) {
+          candidates.push_back(next_state);
         }
+      }
+    }
+  });
 
-        // Check next state to unvisiting.
-        const unsigned to_hash = next_syn_state.Hash(kNumCodeSmStates);
-        VisitingState vis_state = states_visiting[to_hash];
-        if (syn_state.is_tivial) {
-          if (vis_state == FREE) {
-            states_visiting[to_hash] = FREE_FOR_NONTRIVIAL;
-
-            // Check triviality of new path.
-            if (sequnce_length % 2 == 1 &&
-                syn_state.sequence[sequnce_length - 1] + new_char != 0) {
-              next_syn_state.is_tivial = false;
-            }
-          } else {
-            continue;  // Skip this transition.
-          }
-        }
+  // The first found end state in order of single thread search.
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    if (end_found[i]) {
+      return i;
+    }
+  }
 
-        if (to_hash != kEndSynHash || next_syn_state.is_tivial) {
-          vis_state = states_visiting[to_hash];
-          if (vis_state != BUSY) {
-            if (!next_syn_state.is_tivial) {
-              states_visiting[to_hash] = BUSY;
-            }
-            int* new_sequence = new int[sequnce_length + 1];
-            memcpy(new_sequence, next_syn_state.sequence,
-                   sizeof(int) * sequnce_length);
-            new_sequence[sequnce_length] = new_char;
-            next_syn_state.sequence = new_sequence;
-
-            states.push(next_syn_state);
-          }
-        } else {
-          // Extract not bijective words.
-          if (first_bad_word != 0 && second_bad_word != 0) {
-            int symbol;
-            for (unsigned k = 0; k < sequnce_length; ++k) {
-              symbol = next_syn_state.sequence[k];
-              if (symbol > 0) {
-                first_bad_word->push_back(symbol - 1);
-              }
-              else {
-                second_bad_word->push_back(-symbol - 1);
-              }
-            }
-            if (new_char > 0) {
-              first_bad_word->push_back(new_char - 1);
-            }
-            else {
-              second_bad_word->push_back(-new_char - 1);
-            }
-          }
-          while (!states.empty()) {
-            delete[] states.front().sequence;
-            states.pop();
-          }
-          delete[] states_visiting;
-          return true;
-        }
+  chunks_offsets_[0] = 0;
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    chunks_offsets_[i + 1] = chunks_offsets_[i] + chunks_syn_states_[i].size();
+  }
+  const unsigned n_candidates = chunks_offsets_[n_chunks];
+
+  // Candidates of the same state claim it. The first one in order of single
+  // thread search wins.
+  claims.Init(n_candidates);
+  thread_pool_->Run(n_chunks, [&](int chunk, int) {
+    const std::vector<SynonymyState>& candidates = chunks_syn_states_[chunk];
+    const unsigned offset = chunks_offsets_[chunk];
+    for (unsigned i = 0; i < candidates.size(); ++i) {
+      claims.Claim(candidates[i].Hash(kNumCodeSmStates),
+                   candidates[i].is_tivial ? 0 : 1, offset + i);
+    }
+  });
+
+  // Keep winners and mark them visited.
+  states_visiting.Reserve(n_candidates);
+  thread_pool_->Run(n_chunks, [&](int chunk, int) {
+    std::vector<SynonymyState>& candidates = chunks_syn_states_[chunk];
+    const unsigned offset = chunks_offsets_[chunk];
+    unsigned n_winners = 0;
+    for (unsigned i = 0; i < candidates.size(); ++i) {
+      const uint64_t hash = candidates[i].Hash(kNumCodeSmStates);
+      const bool is_tivial = candidates[i].is_tivial;
+      if (claims.GetRank(hash, is_tivial ? 0 : 1) == offset + i) {
+        states_visiting.SetBitsConcurrently(hash, is_tivial ?
+                                                  TRIVIAL_VISITED :
+                                                  NONTRIVIAL_VISITED);
+        candidates[n_winners++] = candidates[i];
       }
-
-      delete[] syn_state.sequence;
-      states.pop();
     }
-    ++sequnce_length;
+    candidates.resize(n_winners);
+  });
+
+  // Append next level keeping order of chunks.
+  chunks_offsets_[0] = level_end;
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    chunks_offsets_[i + 1] = chunks_offsets_[i] + chunks_syn_states_[i].size();
   }
-  delete[] states_visiting;
-  return false;
+  states.resize(chunks_offsets_[n_chunks]);
+  thread_pool_->Run(n_chunks, [&](int chunk, int) {
+    std::copy(chunks_syn_states_[chunk].begin(),
+              chunks_syn_states_[chunk].end(),
+              states.begin() + chunks_offsets_[chunk]);
+  });
+  return -1;
 }
 
-unsigned BijectiveChecker::SynonymyState::Hash(unsigned n_code_sm_states) {
-  return SynonymyState::Hash(deficit->id, upper_state->id, lower_state->id,
+uint64_t BijectiveChecker::SynonymyState::Hash(
+    unsigned n_code_sm_states) const {
+  return SynonymyState::Hash(deficit->id, upper_state, lower_state,
                              n_code_sm_states);
 }
 
-unsigned BijectiveChecker::SynonymyState::Hash(
+uint64_t BijectiveChecker::SynonymyState::Hash(
     unsigned deficit_id, unsigned upper_state_id, unsigned lower_state_id,
     unsigned n_code_sm_states) {
-  return (deficit_id * n_code_sm_states + upper_state_id) * n_code_sm_states +
-      lower_state_id;
+  return (static_cast<uint64_t>(deficit_id) * n_code_sm_states +
+          upper_state_id) * n_code_sm_states + lower_state_id;
+}
+
+void BijectiveChecker::AppendSynonymyWords(
+    const std::vector<SynonymyState>& syn_states, int state_idx,
+    bool from_root, std::vector<int>* first_word,
+    std::vector<int>* second_word) {
+  const unsigned first_word_size = first_word->size();
+  const unsigned second_word_size = second_word->size();
+  for (; state_idx != -1; state_idx = syn_states[state_idx].parent) {
+    const int symbol = syn_states[state_idx].symbol;
+    if (symbol > 0) {
+      first_word->push_back(symbol - 1);
+    } else if (symbol < 0) {
+      second_word->push_back(-symbol - 1);
+    }
+  }
+  if (from_root) {
+    std::reverse(first_word->begin() + first_word_size, first_word->end());
+    std::reverse(second_word->begin() + second_word_size, second_word->end());
+  }
+}
+
+void BijectiveChecker::SetBidirectionalSearch(bool bidirectional) {
+  bidirectional_search_ = bidirectional;
+}
+
+BijectiveChecker::CheckTier BijectiveChecker::GetLastCheckTier() const {
+  return last_check_tier_;
+}
+
+void BijectiveChecker::SetNumberThreads(int n_threads) {
+  delete thread_pool_;
+  thread_pool_ = (n_threads > 1 ? new ThreadPool(n_threads) : 0);
+}
+
+void BijectiveChecker::GetNextSynonymyStates(
+    const SynonymyState& syn_state,
+    std::vector<SynonymyState>* next_states) {
+  const unsigned kIdentityDefId = UnsignedDeficitId(0);
+
+  next_states->clear();
+  State* deficit = syn_state.deficit;
+  const bool lower_moves =
+      SynonymyStep::LowerMoves(SignedDeficitId(deficit->id));
+  const int code_state = (lower_moves ? syn_state.lower_state :
+                                        syn_state.upper_state);
+  const unsigned n_trans = deficit->transitions.size();
+  for (unsigned i = 0; i < n_trans; ++i) {
+    Transition* def_trans = deficit->transitions[i];
+    const int event = def_trans->event_id;
+    const int to = code_machine_->GetNextState(code_state, event);
+    if (to == -1) {
+      continue;
+    }
+    SynonymyState next_state = syn_state;
+    next_state.deficit = def_trans->to;
+    if (lower_moves) {
+      next_state.lower_state = to;
+    } else {
+      next_state.upper_state = to;
+    }
+    next_state.symbol = SynonymyStep::Symbol(lower_moves, event);
+    // Symbol of trivial state at not identity deficit is the leaving code.
+    next_state.is_tivial = SynonymyStep::IsTrivial(
+        syn_state.is_tivial, deficit->id == kIdentityDefId,
+        def_trans->to->id == kIdentityDefId, event,
+        SynonymyStep::CodeId(syn_state.symbol));
+    next_states->push_back(next_state);
+  }
+}
+
+void BijectiveChecker::GetPrevSynonymyStates(
+    const SynonymyState& syn_state,
+    std::vector<SynonymyState>* prev_states) {
+  const unsigned kIdentityDefId = UnsignedDeficitId(0);
+
+  prev_states->clear();
+  State* deficit = syn_state.deficit;
+  const unsigned n_def_trans = deficit->in_transitions.size();
+  for (unsigned i = 0; i < n_def_trans; ++i) {
+    Transition* def_trans = deficit->in_transitions[i];
+    const int event = def_trans->event_id;
+    const bool lower_moves =
+        SynonymyStep::LowerMoves(SignedDeficitId(def_trans->from->id));
+    const int code_state = (lower_moves ? syn_state.lower_state :
+                                          syn_state.upper_state);
+    unsigned n_code_trans;
+    const PreparedTransition* code_trans =
+        code_machine_->GetInTransitions(code_state, &n_code_trans);
+    for (unsigned j = 0; j < n_code_trans; ++j) {
+      if (code_trans[j].event != event) {
+        continue;
+      }
+      SynonymyState prev_state = syn_state;
+      prev_state.deficit = def_trans->from;
+      if (lower_moves) {
+        prev_state.lower_state = code_trans[j].state;
+      } else {
+        prev_state.upper_state = code_trans[j].state;
+      }
+      prev_state.symbol = SynonymyStep::Symbol(lower_moves, event);
+      // Backward path leaves identity deficit by upper word's code and
+      // returns to it by lower word's one.
+      prev_state.is_tivial = SynonymyStep::IsTrivial(
+          syn_state.is_tivial, deficit->id == kIdentityDefId,
+          def_trans->from->id == kIdentityDefId, event,
+          SynonymyStep::CodeId(syn_state.symbol));
+      prev_states->push_back(prev_state);
+    }
+  }
+}
+
+bool BijectiveChecker::FindSynonymyLoopBidirectional(
+    std::vector<int>* first_bad_word,
+    std::vector<int>* second_bad_word) {
+  const unsigned kIdentityDefId = UnsignedDeficitId(0);
+  const unsigned kNumDefSmStates =
+      code_->GetDeficitsStateMachine().GetNumberStates();
+  const unsigned kNumCodeSmStates = code_machine_->GetNumberStates();
+  const uint64_t kMaxNumSynStates = static_cast<uint64_t>(kNumDefSmStates) *
+                                    kNumCodeSmStates * kNumCodeSmStates;
+
+  // Index 0 for forward search, 1 for backward one.
+  SynonymyStatesMap* states_visiting[] = { &states_visiting_,
+                                           &backward_states_visiting_ };
+  std::vector<SynonymyState>* states[] = { &syn_states_,
+                                           &backward_syn_states_ };
+  unsigned level_begin[] = { 0, 0 };
+
+  SynonymyState syn_state;
+  syn_state.deficit =
+      code_->GetDeficitsStateMachine().GetState(kIdentityDefId);
+  syn_state.parent = -1;
+  syn_state.symbol = 0;
+  syn_state.is_tivial = true;
+  for (int i = 0; i < 2; ++i) {
+    const int code_sm_state_id = (i == 0 ? 0 : kNumCodeSmStates - 1);
+    syn_state.upper_state = code_sm_state_id;
+    syn_state.lower_state = code_sm_state_id;
+    states_visiting[i]->Init(kMaxNumSynStates);
+    states_visiting[i]->Set(syn_state.Hash(kNumCodeSmStates),
+                            FREE_FOR_NONTRIVIAL);
+    states[i]->clear();
+    states[i]->push_back(syn_state);
+  }
+
+  // States at which searches met. Visiting state of another search is
+  // BUSY or state is nontrivial itself.
+  std::vector<int> meetings;
+  while (true) {
+    const unsigned n_forward = states[0]->size() - level_begin[0];
+    const unsigned n_backward = states[1]->size() - level_begin[1];
+    if (n_forward == 0 || n_backward == 0) {
+      return false;
+    }
+    // Expand smaller level.
+    const int dir = (n_forward <= n_backward ? 0 : 1);
+    std::vector<SynonymyState>& dir_states = *states[dir];
+    const unsigned level_end = dir_states.size();
+    for (unsigned i = level_begin[dir]; i < level_end; ++i) {
+      syn_state = dir_states[i];
+      if (dir == 0) {
+        GetNextSynonymyStates(syn_state, &next_syn_states_);
+      } else {
+        GetPrevSynonymyStates(syn_state, &next_syn_states_);
+      }
+      for (unsigned j = 0; j < next_syn_states_.size(); ++j) {
+        SynonymyState& next_state = next_syn_states_[j];
+        const uint64_t hash = next_state.Hash(kNumCodeSmStates);
+
+        // Nontrivial path dominates trivial one.
+        const unsigned char vis_state = states_visiting[dir]->Get(hash);
+        if (vis_state == BUSY ||
+            (vis_state == FREE_FOR_NONTRIVIAL && next_state.is_tivial)) {
+          continue;
+        }
+        states_visiting[dir]->Set(hash, next_state.is_tivial ?
+                                        FREE_FOR_NONTRIVIAL : BUSY);
+        next_state.parent = i;
+        dir_states.push_back(next_state);
+
+        const unsigned char other_vis_state =
+            states_visiting[1 - dir]->Get(hash);
+        if (other_vis_state == BUSY ||
+            (other_vis_state == FREE_FOR_NONTRIVIAL &&
+             !next_state.is_tivial)) {
+          meetings.push_back(dir_states.size() - 1);
+        }
+      }
+    }
+    level_begin[dir] = level_end;
+
+    if (!meetings.empty()) {
+      if (first_bad_word == 0 || second_bad_word == 0) {
+        return true;
+      }
+      // Other search is scanned in order of reaching so the first matched
+      // state gives the shortest loop.
+      std::multimap<uint64_t, int> meetings_hashes;
+      for (unsigned i = 0; i < meetings.size(); ++i) {
+        meetings_hashes.insert(std::make_pair(
+            dir_states[meetings[i]].Hash(kNumCodeSmStates), meetings[i]));
+      }
+      const std::vector<SynonymyState>& other_states = *states[1 - dir];
+      for (unsigned i = 0; i < other_states.size(); ++i) {
+        typedef std::multimap<uint64_t, int>::iterator Iterator;
+        std::pair<Iterator, Iterator> range = meetings_hashes.equal_range(
+            other_states[i].Hash(kNumCodeSmStates));
+        for (Iterator it = range.first; it != range.second; ++it) {
+          if (other_states[i].is_tivial && dir_states[it->second].is_tivial) {
+            continue;
+          }
+          const int forward_idx = (dir == 0 ? it->second : i);
+          const int backward_idx = (dir == 0 ? i : it->second);
+          AppendSynonymyWords(*states[0], forward_idx, true, first_bad_word,
+                              second_bad_word);
+          AppendSynonymyWords(*states[1], backward_idx, false, first_bad_word,
+                              second_bad_word);
+          return true;
+        }
+      }
+    }
+  }
 }
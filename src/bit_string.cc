@@ -0,0 +1,36 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/bit_string.h"
+
+BitString::BitString()
+  : length_(0) {
+}
+
+BitString::BitString(const std::string& str) {
+  Assign(str);
+}
+
+void BitString::Assign(const std::string& str) {
+  length_ = str.length();
+  words_.assign((length_ + 63) / 64, 0);
+  for (unsigned i = 0; i < length_; ++i) {
+    if (str[i] == '1') {
+      words_[i >> 6] |= 1ull << (i & 63);
+    }
+  }
+}
+
+uint64_t BitString::GetBits(unsigned pos, unsigned n_bits) const {
+  if (n_bits == 0) {
+    return 0;
+  }
+  const unsigned word_id = pos >> 6;
+  const unsigned shift = pos & 63;
+  uint64_t bits = words_[word_id] >> shift;
+  if (shift != 0 && shift + n_bits > 64) {
+    bits |= words_[word_id + 1] << (64 - shift);
+  }
+  return (n_bits == 64 ? bits : bits & ((1ull << n_bits) - 1));
+}
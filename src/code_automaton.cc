@@ -0,0 +1,46 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/code_automaton.h"
+
+template<int kRadix>
+void BasicCodeAutomaton<kRadix>::Build(
+    const BasicCodeTree<kRadix>& code_tree) {
+  const unsigned n_states = code_tree.GetNumberNodes();
+  next_states_.resize(kRadix * n_states);
+  failures_.resize(n_states);
+  outputs_.resize(n_states);
+  depths_.resize(n_states);
+
+  // Breadth-first traversal: failure of state is less deep so it's
+  // processed before.
+  failures_[0] = 0;
+  outputs_[0] = -1;
+  depths_[0] = 0;
+  queue_.clear();
+  queue_.push_back(0);
+  for (unsigned head = 0; head < queue_.size(); ++head) {
+    const int state = queue_[head];
+    for (int symbol = 0; symbol < kRadix; ++symbol) {
+      const int child = code_tree.GetChild(state, symbol);
+      if (child == -1) {
+        next_states_[kRadix * state + symbol] = (state == 0 ? 0 :
+            next_states_[kRadix * failures_[state] + symbol]);
+        continue;
+      }
+      next_states_[kRadix * state + symbol] = child;
+      failures_[child] = (state == 0 ? 0 :
+          next_states_[kRadix * failures_[state] + symbol]);
+      outputs_[child] = (code_tree.GetElemCode(child) ? child :
+                         outputs_[failures_[child]]);
+      depths_[child] = depths_[state] + 1;
+      queue_.push_back(child);
+    }
+  }
+}
+
+template class BasicCodeAutomaton<2>;
+template class BasicCodeAutomaton<3>;
+template class BasicCodeAutomaton<4>;
+template class BasicCodeAutomaton<256>;
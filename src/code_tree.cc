@@ -4,24 +4,176 @@
 
 #include "include/code_tree.h"
 
-CodeTree::CodeTree(const std::vector<ElementaryCode*>& code) {
-  root_ = new CodeTreeNode();
-  Add(code);
+#include <algorithm>
+
+template<int kRadix>
+BasicCodeTree<kRadix>::BasicCodeTree()
+  : code_(0) {
+  Clear();
+}
+
+template<int kRadix>
+BasicCodeTree<kRadix>::BasicCodeTree(const std::vector<ElementaryCode*>& code)
+  : code_(0) {
+  Build(code);
 }
 
-void CodeTree::Add(const std::vector<ElementaryCode*>& code) {
+template<int kRadix>
+void BasicCodeTree<kRadix>::Build(const std::vector<ElementaryCode*>& code) {
+  Clear();
+  code_ = &code;
+  next_equal_codes_.assign(code.size(), -1);
   const unsigned size = code.size();
   for (unsigned i = 0; i < size; ++i) {
-    CodeTreeNode::Add(root_, code[i]);
+    Add(code[i], i);
+  }
+  SortElemCodes();
+  code_ = 0;
+}
+
+template<int kRadix>
+void BasicCodeTree<kRadix>::Clear() {
+  nodes_.clear();
+  sorted_elem_codes_.clear();
+  NewNode();  // Root.
+}
+
+template<int kRadix>
+int BasicCodeTree<kRadix>::NewNode() {
+  Node node;
+  std::fill(node.childs, node.childs + kRadix, -1);
+  node.elem_code = 0;
+  node.lower_begin = 0;
+  node.n_lower_elem_codes = 0;
+  node.first_code = node.last_code = -1;
+  nodes_.push_back(node);
+  return nodes_.size() - 1;
+}
+
+template<int kRadix>
+void BasicCodeTree<kRadix>::Add(ElementaryCode* elem_code,
+                                int elem_code_idx) {
+  const Word& word = Alphabet<kRadix>::GetWord(*elem_code);
+  const unsigned length = Alphabet<kRadix>::GetLength(word);
+  int node_id = 0;
+  for (unsigned i = 0; i < length; ++i) {
+    ++nodes_[node_id].n_lower_elem_codes;
+    const int child_id = Alphabet<kRadix>::GetSymbol(word, i);
+    int child = nodes_[node_id].childs[child_id];
+    if (child == -1) {
+      // Don't keep reference to node: vector may be reallocated.
+      child = NewNode();
+      nodes_[node_id].childs[child_id] = child;
+    }
+    node_id = child;
+  }
+  Node& node = nodes_[node_id];
+  ++node.n_lower_elem_codes;
+  node.elem_code = elem_code;
+  if (node.last_code == -1) {
+    node.first_code = elem_code_idx;
+  } else {
+    next_equal_codes_[node.last_code] = elem_code_idx;
+  }
+  node.last_code = elem_code_idx;
+}
+
+template<int kRadix>
+void BasicCodeTree<kRadix>::SortElemCodes() {
+  // Depth-first traversal by stack so long codes don't overflow call stack.
+  stack_.clear();
+  stack_.push_back(0);
+  while (!stack_.empty()) {
+    Node& node = nodes_[stack_.back()];
+    stack_.pop_back();
+    node.lower_begin = sorted_elem_codes_.size();
+    for (int i = node.first_code; i != -1; i = next_equal_codes_[i]) {
+      sorted_elem_codes_.push_back((*code_)[i]);
+    }
+    for (int i = kRadix - 1; i >= 0; --i) {
+      if (node.childs[i] != -1) {
+        stack_.push_back(node.childs[i]);
+      }
+    }
+  }
+}
+
+template<int kRadix>
+int BasicCodeTree<kRadix>::Find(
+    const Word& code, std::vector<ElementaryCode*>* upper_elem_codes) const {
+  return Find(code, 0, Alphabet<kRadix>::GetLength(code), upper_elem_codes);
+}
+
+template<int kRadix>
+int BasicCodeTree<kRadix>::Find(
+    const Word& code, unsigned pos, unsigned length,
+    std::vector<ElementaryCode*>* upper_elem_codes) const {
+  if (upper_elem_codes) upper_elem_codes->clear();
+
+  int node_id = 0;
+  for (unsigned i = 0; i < length; ++i) {
+    node_id = nodes_[node_id].childs[Alphabet<kRadix>::GetSymbol(code,
+                                                                 pos + i)];
+    if (node_id == -1) {
+      return -1;
+    }
+    const Node& node = nodes_[node_id];
+    if (upper_elem_codes && node.elem_code) {
+      upper_elem_codes->push_back(node.elem_code);
+    }
   }
+  return node_id;
 }
 
-CodeTreeNode* CodeTree::Find(
-    const std::string& code,
+template<>
+int BasicCodeTree<2>::Find(
+    const Word& code, unsigned pos, unsigned length,
     std::vector<ElementaryCode*>* upper_elem_codes) const {
-  return CodeTreeNode::Find(root_, code, upper_elem_codes);
+  if (upper_elem_codes) upper_elem_codes->clear();
+
+  // Bits are taken by 64 at once.
+  int node_id = 0;
+  for (unsigned i = 0; i < length; i += 64) {
+    const unsigned n_bits = std::min(64u, length - i);
+    uint64_t bits = code.GetBits(pos + i, n_bits);
+    for (unsigned j = 0; j < n_bits; ++j, bits >>= 1) {
+      node_id = nodes_[node_id].childs[bits & 1];
+      if (node_id == -1) {
+        return -1;
+      }
+      const Node& node = nodes_[node_id];
+      if (upper_elem_codes && node.elem_code) {
+        upper_elem_codes->push_back(node.elem_code);
+      }
+    }
+  }
+  return node_id;
 }
 
-CodeTree::~CodeTree() {
-  delete root_;
+template<int kRadix>
+const std::vector<ElementaryCode*>&
+BasicCodeTree<kRadix>::GetSortedElemCodes() const {
+  return sorted_elem_codes_;
 }
+
+template<int kRadix>
+void BasicCodeTree<kRadix>::GetLowerElemCodes(int node_id, unsigned* begin,
+                                              unsigned* end) const {
+  *begin = nodes_[node_id].lower_begin;
+  *end = *begin + nodes_[node_id].n_lower_elem_codes;
+}
+
+template<int kRadix>
+ElementaryCode* BasicCodeTree<kRadix>::GetElemCode(int node_id) const {
+  return nodes_[node_id].elem_code;
+}
+
+template<int kRadix>
+unsigned BasicCodeTree<kRadix>::GetNumberNodes() const {
+  return nodes_.size();
+}
+
+template class BasicCodeTree<2>;
+template class BasicCodeTree<3>;
+template class BasicCodeTree<4>;
+template class BasicCodeTree<256>;
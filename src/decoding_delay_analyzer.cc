@@ -0,0 +1,105 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/decoding_delay_analyzer.h"
+
+#include <stdlib.h>
+
+#include <algorithm>
+
+#include "include/synonymy_step.h"
+
+bool DecodingDelayAnalyzer::Analyze(const std::vector<std::string>& code,
+                                    const StateMachine& code_state_machine,
+                                    unsigned* n_elem_codes,
+                                    unsigned* n_bits) {
+  own_code_.Build(code);
+  own_machine_.Build(code_state_machine);
+  return Analyze(own_code_, own_machine_, n_elem_codes, n_bits);
+}
+
+bool DecodingDelayAnalyzer::Analyze(const PreparedCodeBase& code,
+                                    const PreparedMachine& code_machine,
+                                    unsigned* n_elem_codes,
+                                    unsigned* n_bits) {
+  graph_.Build(code, code_machine);
+  const unsigned n_states = graph_.GetNumberNodes();
+  const std::vector<ElementaryCode*>& elem_codes = code.GetElemCodes();
+  const unsigned kIdentityDefId = code.UnsignedDeficitId(0);
+
+  // Not trivial states and transitions between them make graph which is
+  // sorted topologically. Not trivial path never becomes trivial.
+  n_in_transitions_.assign(n_states, 0);
+  for (unsigned i = 0; i < n_states; ++i) {
+    unsigned n_edges;
+    const SynonymyGraph::Edge* edges = graph_.GetEdges(i, &n_edges);
+    for (unsigned j = 0; j < n_edges; ++j) {
+      ++n_in_transitions_[edges[j].to];
+    }
+  }
+  n_path_codes_.assign(n_states, -1);
+  n_path_bits_.assign(n_states, -1);
+  queue_.clear();
+  for (unsigned i = 0; i < n_states; ++i) {
+    const SynonymyGraph::Node& node = graph_.GetNode(i);
+    if (node.is_tivial) {
+      // Trivial path since the last identity deficit is a single code of
+      // lower parsing.
+      const bool is_identity = node.deficit->id == kIdentityDefId;
+      n_path_codes_[i] = (is_identity ? 0 : 1);
+      n_path_bits_[i] = GetDeficitLength(code, node.deficit);
+      queue_.push_back(i);
+    }
+  }
+  unsigned n_max_codes = 0;
+  unsigned n_max_bits = 0;
+  unsigned n_sorted = 0;
+  for (unsigned head = 0; head < queue_.size(); ++head) {
+    const int state = queue_[head];
+    const SynonymyGraph::Node& node = graph_.GetNode(state);
+    if (!node.is_tivial) {
+      ++n_sorted;
+      n_max_codes = std::max(n_max_codes,
+                             static_cast<unsigned>(n_path_codes_[state]));
+      // Both parsings have the same length without deficit.
+      n_max_bits = std::max(n_max_bits,
+                            (n_path_bits_[state] +
+                             GetDeficitLength(code, node.deficit)) / 2);
+    }
+    unsigned n_edges;
+    const SynonymyGraph::Edge* edges = graph_.GetEdges(state, &n_edges);
+    for (unsigned i = 0; i < n_edges; ++i) {
+      const int to = edges[i].to;
+      if (graph_.GetNode(to).is_tivial) {
+        continue;
+      }
+      const int code_id = SynonymyStep::CodeId(edges[i].symbol);
+      const int n_codes = n_path_codes_[state] + 1;
+      const int n_bits = n_path_bits_[state] +
+                         elem_codes[code_id]->str.size();
+      n_path_codes_[to] = std::max(n_path_codes_[to], n_codes);
+      n_path_bits_[to] = std::max(n_path_bits_[to], n_bits);
+      if (--n_in_transitions_[to] == 0) {
+        queue_.push_back(to);
+      }
+    }
+  }
+
+  // States at loops are never sorted.
+  unsigned n_nontrivial = 0;
+  for (unsigned i = 0; i < n_states; ++i) {
+    n_nontrivial += !graph_.GetNode(i).is_tivial;
+  }
+  if (n_sorted != n_nontrivial) {
+    return false;
+  }
+  *n_elem_codes = n_max_codes;
+  *n_bits = n_max_bits;
+  return true;
+}
+
+unsigned DecodingDelayAnalyzer::GetDeficitLength(const PreparedCodeBase& code,
+                                                 const State* deficit) const {
+  return code.GetSuffixes()[abs(code.SignedDeficitId(deficit->id))]->length;
+}
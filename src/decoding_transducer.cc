@@ -0,0 +1,310 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/decoding_transducer.h"
+
+#include <algorithm>
+
+#include "include/bijective_checker.h"
+
+const int DecodingTransducer::kStartState;
+
+DecodingTransducer::DecodingTransducer()
+  : code_tree_(0), code_machine_(0), has_next_codes_(0), n_code_states_(0),
+    max_n_pending_(0) {}
+
+bool DecodingTransducer::Build(const std::vector<std::string>& code,
+                               const StateMachine& code_state_machine,
+                               unsigned max_n_states) {
+  Clear();
+  for (unsigned i = 0; i < code.size(); ++i) {
+    if (code[i].empty()) {
+      return false;
+    }
+  }
+  own_code_.Build(code);
+  own_machine_.Build(code_state_machine);
+  int first_duplicate_id, second_duplicate_id;
+  BijectiveChecker checker;
+  if (own_code_.GetDuplicates(&first_duplicate_id, &second_duplicate_id) ||
+      !checker.IsBijective(own_code_, own_machine_)) {
+    return false;
+  }
+  unsigned n_delay_codes, n_delay_bits;
+  if (!delay_analyzer_.Analyze(own_code_, own_machine_, &n_delay_codes,
+                               &n_delay_bits)) {
+    return false;
+  }
+  own_code_tree_.Build(own_code_.GetElemCodes());
+  FindNextCodes(own_code_tree_, own_machine_, &own_has_next_codes_);
+  return Build(own_code_tree_, own_machine_, own_has_next_codes_,
+               max_n_states);
+}
+
+bool DecodingTransducer::Build(const CodeTree& code_tree,
+                               const PreparedMachine& code_machine,
+                               const std::vector<bool>& has_next_codes,
+                               unsigned max_n_states) {
+  Clear();
+  code_tree_ = &code_tree;
+  code_machine_ = &code_machine;
+  has_next_codes_ = &has_next_codes;
+  n_code_states_ = code_machine.GetNumberStates();
+  const bool is_built = BuildStates(max_n_states);
+  code_tree_ = 0;
+  code_machine_ = 0;
+  has_next_codes_ = 0;
+  return is_built;
+}
+
+void DecodingTransducer::FindNextCodes(const CodeTree& code_tree,
+                                       const PreparedMachine& code_machine,
+                                       std::vector<bool>* has_next_codes) {
+  // Children have greater ids than parents.
+  const unsigned n_nodes = code_tree.GetNumberNodes();
+  const unsigned n_code_states = code_machine.GetNumberStates();
+  has_next_codes->assign(n_nodes * n_code_states, false);
+  for (int i = n_nodes - 1; i >= 0; --i) {
+    for (unsigned j = 0; j < n_code_states; ++j) {
+      bool has_next = false;
+      for (int k = 0; k < 2 && !has_next; ++k) {
+        const int child = code_tree.GetChild(i, k);
+        if (child != -1) {
+          ElementaryCode* elem_code = code_tree.GetElemCode(child);
+          has_next = (elem_code &&
+                      code_machine.GetNextState(j, elem_code->id) != -1) ||
+                     (*has_next_codes)[child * n_code_states + j];
+        }
+      }
+      (*has_next_codes)[i * n_code_states + j] = has_next;
+    }
+  }
+}
+
+void DecodingTransducer::Clear() {
+  states_hypotheses_.clear();
+  states_ids_.clear();
+  bit_next_states_.clear();
+  bit_output_offsets_.assign(1, 0);
+  byte_next_states_.clear();
+  byte_output_offsets_.assign(1, 0);
+  final_states_.clear();
+  final_output_offsets_.assign(1, 0);
+  outputs_.clear();
+  max_n_pending_ = 0;
+}
+
+bool DecodingTransducer::BuildStates(unsigned max_n_states) {
+
+  // States are queued by GetState().
+  std::vector<Hypothesis> hypotheses(1);
+  hypotheses[0].node = 0;
+  hypotheses[0].state = 0;
+  GetState(hypotheses);
+  std::vector<int> emitted;
+  for (unsigned i = 0; i < states_hypotheses_.size(); ++i) {
+    hypotheses = states_hypotheses_[i];
+    for (int bit = 0; bit < 2; ++bit) {
+      emitted.clear();
+      bit_next_states_.push_back(Step(hypotheses, bit, &emitted));
+      outputs_.insert(outputs_.end(), emitted.begin(), emitted.end());
+      bit_output_offsets_.push_back(outputs_.size());
+      if (states_hypotheses_.size() > max_n_states) {
+        return false;
+      }
+    }
+  }
+  const unsigned n_states = states_hypotheses_.size();
+
+  // Stream ends at root of code tree and final state of code state machine.
+  const int final_code_state = n_code_states_ - 1;
+  final_states_.resize(n_states, false);
+  final_output_offsets_.assign(1, outputs_.size());
+  for (unsigned i = 0; i < n_states; ++i) {
+    const std::vector<Hypothesis>& hypotheses = states_hypotheses_[i];
+    for (unsigned j = 0; j < hypotheses.size(); ++j) {
+      max_n_pending_ = std::max<unsigned>(max_n_pending_,
+                                          hypotheses[j].pending.size());
+      if (hypotheses[j].node == 0 &&
+          hypotheses[j].state == final_code_state) {
+        final_states_[i] = true;
+        outputs_.insert(outputs_.end(), hypotheses[j].pending.begin(),
+                        hypotheses[j].pending.end());
+      }
+    }
+    final_output_offsets_.push_back(outputs_.size());
+  }
+  states_hypotheses_.clear();
+  states_ids_.clear();
+
+  // Transitions by bytes are transitions by 8 bits.
+  byte_next_states_.resize(n_states * 256);
+  byte_output_offsets_.reserve(n_states * 256 + 1);
+  byte_output_offsets_.assign(1, outputs_.size());
+  for (unsigned i = 0; i < n_states; ++i) {
+    for (unsigned byte = 0; byte < 256; ++byte) {
+      int state = i;
+      for (int j = 0; j < 8 && state != -1; ++j) {
+        const unsigned idx = state * 2 + ((byte >> j) & 1);
+        for (unsigned k = bit_output_offsets_[idx];
+             k < bit_output_offsets_[idx + 1]; ++k) {
+          const int symbol = outputs_[k];
+          outputs_.push_back(symbol);
+        }
+        state = bit_next_states_[idx];
+      }
+      byte_next_states_[i * 256 + byte] = state;
+      byte_output_offsets_.push_back(outputs_.size());
+    }
+  }
+  return true;
+}
+
+int DecodingTransducer::Step(const std::vector<Hypothesis>& hypotheses,
+                             int bit, std::vector<int>* emitted) {
+  std::vector<Hypothesis> next_hypotheses;
+  for (unsigned i = 0; i < hypotheses.size(); ++i) {
+    const Hypothesis& hypothesis = hypotheses[i];
+    const int node = code_tree_->GetChild(hypothesis.node, bit);
+    if (node == -1) {
+      continue;
+    }
+    ElementaryCode* elem_code = code_tree_->GetElemCode(node);
+    if (elem_code) {
+      const int state = code_machine_->GetNextState(hypothesis.state,
+                                                    elem_code->id);
+      if (state != -1) {
+        next_hypotheses.push_back(hypothesis);
+        next_hypotheses.back().node = 0;
+        next_hypotheses.back().state = state;
+        next_hypotheses.back().pending.push_back(elem_code->id);
+      }
+    }
+    if ((*has_next_codes_)[node * n_code_states_ + hypothesis.state]) {
+      next_hypotheses.push_back(hypothesis);
+      next_hypotheses.back().node = node;
+    }
+  }
+  if (next_hypotheses.empty()) {
+    return -1;
+  }
+  // Hypotheses with the same node and state have the same future, so only
+  // the first one is kept.
+  std::stable_sort(next_hypotheses.begin(), next_hypotheses.end(),
+                   IsLess);
+  next_hypotheses.erase(std::unique(next_hypotheses.begin(),
+                                    next_hypotheses.end(), IsEqual),
+                        next_hypotheses.end());
+
+  while (true) {
+    const std::vector<int>& pending = next_hypotheses[0].pending;
+    if (pending.empty()) {
+      break;
+    }
+    const int code_id = pending[0];
+    bool is_agreed = true;
+    for (unsigned i = 1; i < next_hypotheses.size() && is_agreed; ++i) {
+      is_agreed = !next_hypotheses[i].pending.empty() &&
+                  next_hypotheses[i].pending[0] == code_id;
+    }
+    if (!is_agreed) {
+      break;
+    }
+    emitted->push_back(code_id);
+    for (unsigned i = 0; i < next_hypotheses.size(); ++i) {
+      next_hypotheses[i].pending.erase(next_hypotheses[i].pending.begin());
+    }
+  }
+  return GetState(next_hypotheses);
+}
+
+bool DecodingTransducer::IsLess(const Hypothesis& first,
+                                const Hypothesis& second) {
+  return first.node < second.node ||
+         (first.node == second.node && first.state < second.state);
+}
+
+bool DecodingTransducer::IsEqual(const Hypothesis& first,
+                                 const Hypothesis& second) {
+  return first.node == second.node && first.state == second.state;
+}
+
+int DecodingTransducer::GetState(const std::vector<Hypothesis>& hypotheses) {
+  std::vector<int> key;
+  for (unsigned i = 0; i < hypotheses.size(); ++i) {
+    key.push_back(hypotheses[i].node);
+    key.push_back(hypotheses[i].state);
+    key.push_back(hypotheses[i].pending.size());
+    key.insert(key.end(), hypotheses[i].pending.begin(),
+               hypotheses[i].pending.end());
+  }
+  std::map<std::vector<int>, int>::iterator it = states_ids_.find(key);
+  if (it != states_ids_.end()) {
+    return it->second;
+  }
+  const int state = states_hypotheses_.size();
+  states_ids_[key] = state;
+  states_hypotheses_.push_back(hypotheses);
+  return state;
+}
+
+int DecodingTransducer::Push(const uint8_t* data, unsigned n_bits,
+                             int* state, int* symbols) const {
+  int current_state = *state;
+  int n_symbols = 0;
+  const unsigned n_bytes = n_bits / 8;
+  const int* outputs = outputs_.data();
+  for (unsigned i = 0; i < n_bytes; ++i) {
+    const unsigned idx = current_state * 256 + data[i];
+    current_state = byte_next_states_[idx];
+    if (current_state == -1) {
+      return -1;
+    }
+    for (unsigned j = byte_output_offsets_[idx];
+         j < byte_output_offsets_[idx + 1]; ++j) {
+      symbols[n_symbols++] = outputs[j];
+    }
+  }
+  for (unsigned i = n_bytes * 8; i < n_bits; ++i) {
+    const unsigned idx = current_state * 2 + ((data[i >> 3] >> (i & 7)) & 1);
+    current_state = bit_next_states_[idx];
+    if (current_state == -1) {
+      return -1;
+    }
+    for (unsigned j = bit_output_offsets_[idx];
+         j < bit_output_offsets_[idx + 1]; ++j) {
+      symbols[n_symbols++] = outputs[j];
+    }
+  }
+  *state = current_state;
+  return n_symbols;
+}
+
+int DecodingTransducer::Finish(int state, int* symbols) const {
+  if (!final_states_[state]) {
+    return -1;
+  }
+  std::copy(outputs_.begin() + final_output_offsets_[state],
+            outputs_.begin() + final_output_offsets_[state + 1], symbols);
+  return final_output_offsets_[state + 1] - final_output_offsets_[state];
+}
+
+int DecodingTransducer::Decode(const uint8_t* data, unsigned n_bits,
+                               int* symbols) const {
+  int state = kStartState;
+  const int n_symbols = Push(data, n_bits, &state, symbols);
+  if (n_symbols == -1) {
+    return -1;
+  }
+  const int n_final_symbols = Finish(state, symbols + n_symbols);
+  return (n_final_symbols == -1 ? -1 : n_symbols + n_final_symbols);
+}
+
+unsigned DecodingTransducer::GetNumberStates() const {
+  return final_states_.size();
+}
+
+unsigned DecodingTransducer::GetMaxNumberPending() const {
+  return max_n_pending_;
+}
@@ -0,0 +1,374 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/incremental_bijective_checker.h"
+
+#include <algorithm>
+
+#include "include/synonymy_step.h"
+
+IncrementalBijectiveChecker::IncrementalBijectiveChecker()
+  : n_code_sm_states_(0),
+    is_search_valid_(false),
+    is_end_found_(false),
+    is_last_check_incremental_(false),
+    head_(0) {
+}
+
+void IncrementalBijectiveChecker::Init(const std::vector<std::string>& code,
+                                       const StateMachine& code_state_machine) {
+  code_ = code;
+  n_code_sm_states_ = code_state_machine.GetNumberStates();
+  code_transitions_.clear();
+  for (unsigned i = 0; i < n_code_sm_states_; ++i) {
+    const std::vector<Transition*>& transitions =
+        code_state_machine.GetState(i)->transitions;
+    for (unsigned j = 0; j < transitions.size(); ++j) {
+      CodeTransition trans;
+      trans.from = i;
+      trans.to = transitions[j]->to->id;
+      trans.event = transitions[j]->event_id;
+      code_transitions_.push_back(trans);
+    }
+  }
+  BuildCodeStateMachine();
+  prepared_code_.Build(code_);
+  GetDeficitsTransitions(&deficits_transitions_);
+  is_search_valid_ = false;
+}
+
+void IncrementalBijectiveChecker::AddElemCode(const std::string& elem_code) {
+  code_.push_back(elem_code);
+  prepared_code_.Build(code_);
+
+  // Ids of suffixes of previous codes are kept because they are numbered in
+  // order of codes. So old deficits transitions stay and deficits with new
+  // ones are touched.
+  GetDeficitsTransitions(&new_deficits_transitions_);
+  const std::vector<DeficitTransition>& old_transitions =
+      deficits_transitions_;
+  const std::vector<DeficitTransition>& new_transitions =
+      new_deficits_transitions_;
+  if (!std::includes(new_transitions.begin(), new_transitions.end(),
+                     old_transitions.begin(), old_transitions.end())) {
+    is_search_valid_ = false;
+  }
+  unsigned old_idx = 0;
+  for (unsigned i = 0; i < new_transitions.size(); ++i) {
+    while (old_idx < old_transitions.size() &&
+           old_transitions[old_idx] < new_transitions[i]) {
+      ++old_idx;
+    }
+    if (old_idx == old_transitions.size() ||
+        new_transitions[i] < old_transitions[old_idx]) {
+      touched_deficits_.push_back(new_transitions[i].from);
+    }
+  }
+  deficits_transitions_.swap(new_deficits_transitions_);
+}
+
+void IncrementalBijectiveChecker::RemoveElemCode(int id) {
+  code_.erase(code_.begin() + id);
+  unsigned n_transitions = 0;
+  for (unsigned i = 0; i < code_transitions_.size(); ++i) {
+    CodeTransition trans = code_transitions_[i];
+    if (trans.event != id) {
+      if (trans.event > id) {
+        --trans.event;
+      }
+      code_transitions_[n_transitions++] = trans;
+    }
+  }
+  code_transitions_.resize(n_transitions);
+  BuildCodeStateMachine();
+  prepared_code_.Build(code_);
+  GetDeficitsTransitions(&deficits_transitions_);
+  is_search_valid_ = false;
+}
+
+void IncrementalBijectiveChecker::AddTransition(unsigned from_id,
+                                                unsigned to_id,
+                                                int event_id) {
+  // Only the first transition by event is used.
+  bool is_used = true;
+  for (unsigned i = 0; i < code_transitions_.size(); ++i) {
+    if (code_transitions_[i].from == from_id &&
+        code_transitions_[i].event == event_id) {
+      is_used = false;
+      break;
+    }
+  }
+  CodeTransition trans;
+  trans.from = from_id;
+  trans.to = to_id;
+  trans.event = event_id;
+  code_transitions_.push_back(trans);
+
+  if (std::max(from_id, to_id) >= n_code_sm_states_) {
+    n_code_sm_states_ = std::max(from_id, to_id) + 1;
+    is_search_valid_ = false;
+  }
+  BuildCodeStateMachine();
+  if (is_used) {
+    touched_code_sm_states_.push_back(from_id);
+  }
+}
+
+void IncrementalBijectiveChecker::RemoveTransition(unsigned from_id,
+                                                   unsigned to_id,
+                                                   int event_id) {
+  bool is_used = true;
+  for (unsigned i = 0; i < code_transitions_.size(); ++i) {
+    const CodeTransition& trans = code_transitions_[i];
+    if (trans.from != from_id || trans.event != event_id) {
+      continue;
+    }
+    if (trans.to == to_id) {
+      code_transitions_.erase(code_transitions_.begin() + i);
+      BuildCodeStateMachine();
+      if (is_used) {
+        is_search_valid_ = false;
+      }
+      return;
+    }
+    is_used = false;
+  }
+}
+
+bool IncrementalBijectiveChecker::IsBijective(
+    std::vector<int>* first_bad_word, std::vector<int>* second_bad_word) {
+  if (first_bad_word) first_bad_word->clear();
+  if (second_bad_word) second_bad_word->clear();
+  is_last_check_incremental_ = false;
+
+  // The same cheap checks as BijectiveChecker does. Synonymy states are not
+  // expanded by touched deficits and transitions if one of them passes, so
+  // kept search is dropped and started from scratch next time.
+  int first_duplicate_id, second_duplicate_id;
+  if (prepared_machine_.AcceptsAllWords(code_.size()) &&
+      prepared_code_.GetDuplicates(&first_duplicate_id,
+                                   &second_duplicate_id)) {
+    if (first_bad_word != 0 && second_bad_word != 0) {
+      first_bad_word->push_back(first_duplicate_id);
+      second_bad_word->push_back(second_duplicate_id);
+    }
+    DropSearch();
+    return false;
+  }
+  if (prepared_code_.IsPrefixFree() || prepared_code_.IsSuffixFree()) {
+    DropSearch();
+    return true;
+  }
+
+  if (is_search_valid_) {
+    is_last_check_incremental_ = true;
+    // Found words are not changed by adding of codes and transitions.
+    if (!is_end_found_) {
+      ExpandTouchedStates();
+      is_end_found_ = is_end_found_ || ContinueSearch();
+    }
+  } else {
+    StartSearch();
+    is_end_found_ = ContinueSearch();
+    is_search_valid_ = true;
+  }
+  touched_deficits_.clear();
+  touched_code_sm_states_.clear();
+
+  if (is_end_found_ && first_bad_word != 0 && second_bad_word != 0) {
+    ExtractWords(first_bad_word, second_bad_word);
+  }
+  return !is_end_found_;
+}
+
+bool IncrementalBijectiveChecker::IsLastCheckIncremental() const {
+  return is_last_check_incremental_;
+}
+
+const std::vector<std::string>& IncrementalBijectiveChecker::GetCode() const {
+  return code_;
+}
+
+const StateMachine& IncrementalBijectiveChecker::GetCodeStateMachine() const {
+  return code_state_machine_;
+}
+
+bool IncrementalBijectiveChecker::DeficitTransition::operator<(
+    const DeficitTransition& other) const {
+  if (from != other.from) {
+    return from < other.from;
+  }
+  if (event != other.event) {
+    return event < other.event;
+  }
+  return to < other.to;
+}
+
+void IncrementalBijectiveChecker::BuildCodeStateMachine() {
+  code_state_machine_.Init(n_code_sm_states_);
+  for (unsigned i = 0; i < code_transitions_.size(); ++i) {
+    code_state_machine_.AddTransition(code_transitions_[i].from,
+                                      code_transitions_[i].to,
+                                      code_transitions_[i].event);
+  }
+  prepared_machine_.Build(code_state_machine_);
+}
+
+void IncrementalBijectiveChecker::GetDeficitsTransitions(
+    std::vector<DeficitTransition>* transitions) {
+  const StateMachine& deficits = prepared_code_.GetDeficitsStateMachine();
+  const int n_deficits = deficits.GetNumberStates();
+  transitions->clear();
+  for (int i = 0; i < n_deficits; ++i) {
+    const std::vector<Transition*>& def_transitions =
+        deficits.GetState(i)->transitions;
+    for (unsigned j = 0; j < def_transitions.size(); ++j) {
+      DeficitTransition trans;
+      trans.from = prepared_code_.SignedDeficitId(i);
+      trans.event = def_transitions[j]->event_id;
+      trans.to = prepared_code_.SignedDeficitId(def_transitions[j]->to->id);
+      transitions->push_back(trans);
+    }
+  }
+  std::sort(transitions->begin(), transitions->end());
+}
+
+uint64_t IncrementalBijectiveChecker::Key(int deficit, unsigned upper_state,
+                                          unsigned lower_state) const {
+  const uint64_t deficit_key = (deficit >= 0 ? 2ull * deficit :
+                                               2ull * -deficit - 1);
+  return (deficit_key * n_code_sm_states_ + upper_state) * n_code_sm_states_ +
+         lower_state;
+}
+
+void IncrementalBijectiveChecker::StartSearch() {
+  // Keys are not bounded by number of states so hash table is used.
+  states_visiting_.Init(~0ull);
+  syn_states_.clear();
+  head_ = 0;
+
+  SynonymyState start_state;
+  start_state.deficit = 0;
+  start_state.upper_state = 0;
+  start_state.lower_state = 0;
+  start_state.parent = -1;
+  start_state.symbol = 0;
+  start_state.is_tivial = true;
+  syn_states_.push_back(start_state);
+  states_visiting_.Set(Key(0, 0, 0), TRIVIAL_VISITED);
+}
+
+bool IncrementalBijectiveChecker::ContinueSearch() {
+  while (head_ < syn_states_.size()) {
+    if (Expand(head_++)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void IncrementalBijectiveChecker::DropSearch() {
+  is_search_valid_ = false;
+  touched_deficits_.clear();
+  touched_code_sm_states_.clear();
+}
+
+bool IncrementalBijectiveChecker::Expand(unsigned state_idx) {
+  const StateMachine& deficits = prepared_code_.GetDeficitsStateMachine();
+  const unsigned kEndCodeSmState = n_code_sm_states_ - 1;
+
+  // Copy because states may be reallocated.
+  const SynonymyState syn_state = syn_states_[state_idx];
+  State* deficit =
+      deficits.GetState(prepared_code_.UnsignedDeficitId(syn_state.deficit));
+  const bool lower_moves = SynonymyStep::LowerMoves(syn_state.deficit);
+  const int code_state = (lower_moves ? syn_state.lower_state :
+                                        syn_state.upper_state);
+  const unsigned n_trans = deficit->transitions.size();
+  for (unsigned i = 0; i < n_trans; ++i) {
+    Transition* def_trans = deficit->transitions[i];
+    const int event = def_trans->event_id;
+    const int to = prepared_machine_.GetNextState(code_state, event);
+    if (to == -1) {
+      continue;
+    }
+    SynonymyState next_state = syn_state;
+    next_state.deficit = prepared_code_.SignedDeficitId(def_trans->to->id);
+    next_state.parent = state_idx;
+    if (lower_moves) {
+      next_state.lower_state = to;
+    } else {
+      next_state.upper_state = to;
+    }
+    next_state.symbol = SynonymyStep::Symbol(lower_moves, event);
+    // Leaving code is symbol of trivial state (see BijectiveChecker).
+    next_state.is_tivial = SynonymyStep::IsTrivial(
+        syn_state.is_tivial, syn_state.deficit == 0, next_state.deficit == 0,
+        event, SynonymyStep::CodeId(syn_state.symbol));
+
+    if (!next_state.is_tivial && next_state.deficit == 0 &&
+        next_state.upper_state == static_cast<int>(kEndCodeSmState) &&
+        next_state.lower_state == static_cast<int>(kEndCodeSmState)) {
+      // End state is the last one.
+      syn_states_.push_back(next_state);
+      return true;
+    }
+
+    const uint64_t key = Key(next_state.deficit, next_state.upper_state,
+                             next_state.lower_state);
+    const unsigned char bit = (next_state.is_tivial ? TRIVIAL_VISITED :
+                                                      NONTRIVIAL_VISITED);
+    const unsigned char vis_state = states_visiting_.Get(key);
+    if ((vis_state & bit) == 0) {
+      states_visiting_.Set(key, vis_state | bit);
+      syn_states_.push_back(next_state);
+    }
+  }
+  return false;
+}
+
+void IncrementalBijectiveChecker::ExpandTouchedStates() {
+  const unsigned n_deficits =
+      prepared_code_.GetDeficitsStateMachine().GetNumberStates();
+  is_touched_deficit_.assign(n_deficits, false);
+  is_touched_code_sm_state_.assign(n_code_sm_states_, false);
+  for (unsigned i = 0; i < touched_deficits_.size(); ++i) {
+    is_touched_deficit_[
+        prepared_code_.UnsignedDeficitId(touched_deficits_[i])] = true;
+  }
+  for (unsigned i = 0; i < touched_code_sm_states_.size(); ++i) {
+    is_touched_code_sm_state_[touched_code_sm_states_[i]] = true;
+  }
+
+  // All reached states are expanded already. New ones are added to queue.
+  const unsigned n_expanded = head_;
+  for (unsigned i = 0; i < n_expanded; ++i) {
+    const SynonymyState& syn_state = syn_states_[i];
+    const int code_state = (syn_state.deficit >= 0 ? syn_state.lower_state :
+                                                     syn_state.upper_state);
+    if (is_touched_deficit_[
+            prepared_code_.UnsignedDeficitId(syn_state.deficit)] ||
+        is_touched_code_sm_state_[code_state]) {
+      if (Expand(i)) {
+        is_end_found_ = true;
+        return;
+      }
+    }
+  }
+}
+
+void IncrementalBijectiveChecker::ExtractWords(
+    std::vector<int>* first_bad_word, std::vector<int>* second_bad_word) {
+  for (int idx = syn_states_.size() - 1; idx != -1;
+       idx = syn_states_[idx].parent) {
+    const int symbol = syn_states_[idx].symbol;
+    if (symbol > 0) {
+      first_bad_word->push_back(symbol - 1);
+    } else if (symbol < 0) {
+      second_bad_word->push_back(-symbol - 1);
+    }
+  }
+  std::reverse(first_bad_word->begin(), first_bad_word->end());
+  std::reverse(second_bad_word->begin(), second_bad_word->end());
+}
@@ -0,0 +1,199 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/parallel_decoder.h"
+
+#include <algorithm>
+
+const unsigned ParallelDecoder::kMinChunkSize = 1u << 12;
+const unsigned ParallelDecoder::kNumChunksPerThread = 4;
+const unsigned ParallelDecoder::kMaxNumberStarts = 256;
+const unsigned ParallelDecoder::kMaxSpeculativeBytes = 1024;
+
+ParallelDecoder::ParallelDecoder(int n_threads)
+  : thread_pool_(n_threads), transducer_(0), is_speculative_(false) {
+  // Pool has at least one thread.
+  const int n_pool_threads = thread_pool_.GetNumberThreads();
+  threads_runs_.resize(n_pool_threads);
+  threads_next_runs_.resize(n_pool_threads);
+  threads_states_runs_.resize(n_pool_threads);
+}
+
+bool ParallelDecoder::Init(const DecodingTransducer* transducer) {
+  transducer_ = transducer;
+  const unsigned n_states = transducer->GetNumberStates();
+  starts_.assign(1, DecodingTransducer::kStartState);
+  starts_ids_.assign(n_states, -1);
+  starts_ids_[DecodingTransducer::kStartState] = 0;
+  const int* begin;
+  const int* end;
+  for (unsigned i = 0; i < starts_.size() &&
+                       starts_.size() <= kMaxNumberStarts; ++i) {
+    for (unsigned byte = 0; byte < 256; ++byte) {
+      const int state = transducer->GetByteTransition(starts_[i], byte,
+                                                      &begin, &end);
+      if (state != -1 && starts_ids_[state] == -1) {
+        starts_ids_[state] = starts_.size();
+        starts_.push_back(state);
+      }
+    }
+  }
+  is_speculative_ = starts_.size() <= kMaxNumberStarts;
+  for (unsigned i = 0; i < threads_states_runs_.size(); ++i) {
+    threads_states_runs_[i].assign(n_states, -1);
+  }
+  return is_speculative_;
+}
+
+int ParallelDecoder::Decode(const uint8_t* data, unsigned n_bits,
+                            int* symbols) {
+  const unsigned n_bytes = n_bits / 8;
+  const unsigned n_chunks = std::min(thread_pool_.GetNumberThreads() *
+                                     kNumChunksPerThread,
+                                     n_bytes / kMinChunkSize);
+  if (!is_speculative_ || n_chunks <= 1) {
+    return transducer_->Decode(data, n_bits, symbols);
+  }
+  if (chunks_.size() < n_chunks) {
+    chunks_.resize(n_chunks);
+  }
+  thread_pool_.Run(n_chunks, [&](int chunk, int thread) {
+    const unsigned begin = static_cast<uint64_t>(n_bytes) * chunk / n_chunks;
+    const unsigned end = static_cast<uint64_t>(n_bytes) * (chunk + 1) /
+                         n_chunks;
+    const unsigned n_tail_bits = (static_cast<unsigned>(chunk) ==
+                                  n_chunks - 1 ? n_bits % 8 : 0);
+    DecodeChunk(data, begin, end, n_tail_bits, thread, &chunks_[chunk]);
+  });
+
+  // Fix-up pass. Symbols of synchronized chunks are copied later.
+  int state = DecodingTransducer::kStartState;
+  unsigned n_symbols = 0;
+  segments_.clear();
+  for (unsigned i = 0; i < n_chunks; ++i) {
+    const Chunk& chunk = chunks_[i];
+    if (!chunk.is_synchronized) {
+      const unsigned begin = static_cast<uint64_t>(n_bytes) * i / n_chunks;
+      const unsigned end = static_cast<uint64_t>(n_bytes) * (i + 1) /
+                           n_chunks;
+      const unsigned n_tail_bits = (i == n_chunks - 1 ? n_bits % 8 : 0);
+      const int n_decoded = transducer_->Push(data + begin,
+                                              (end - begin) * 8 + n_tail_bits,
+                                              &state, symbols + n_symbols);
+      if (n_decoded == -1) {
+        return -1;
+      }
+      n_symbols += n_decoded;
+      continue;
+    }
+    int run_id = starts_ids_[state];
+    unsigned offset = 0;
+    while (true) {
+      const Run& run = chunk.runs[run_id];
+      Segment segment;
+      segment.begin = run.symbols.data() + offset;
+      segment.end = run.symbols.data() + run.symbols.size();
+      segment.position = n_symbols;
+      segments_.push_back(segment);
+      n_symbols += segment.end - segment.begin;
+      if (run.merged_run == -1) {
+        state = run.state;
+        break;
+      }
+      run_id = run.merged_run;
+      offset = run.merge_offset;
+    }
+    if (state == -1) {
+      return -1;
+    }
+  }
+  const int n_final_symbols = transducer_->Finish(state, symbols + n_symbols);
+  if (n_final_symbols == -1) {
+    return -1;
+  }
+  thread_pool_.Run(segments_.size(), [&](int segment_id, int) {
+    const Segment& segment = segments_[segment_id];
+    std::copy(segment.begin, segment.end, symbols + segment.position);
+  });
+  return n_symbols + n_final_symbols;
+}
+
+bool ParallelDecoder::IsSpeculative() const {
+  return is_speculative_;
+}
+
+void ParallelDecoder::DecodeChunk(const uint8_t* data, unsigned begin,
+                                  unsigned end, unsigned n_tail_bits,
+                                  int thread, Chunk* chunk) {
+  std::vector<int>& runs = threads_runs_[thread];
+  std::vector<int>& next_runs = threads_next_runs_[thread];
+  std::vector<int>& states_runs = threads_states_runs_[thread];
+  const unsigned n_starts = (begin == 0 ? 1 : starts_.size());
+  chunk->runs.resize(starts_.size());
+  chunk->is_synchronized = true;
+  runs.clear();
+  for (unsigned i = 0; i < starts_.size(); ++i) {
+    Run& run = chunk->runs[i];
+    run.state = (i < n_starts ? starts_[i] : -1);
+    run.symbols.clear();
+    run.merged_run = -1;
+    run.merge_offset = 0;
+    if (run.state != -1) {
+      runs.push_back(i);
+    }
+  }
+
+  // Runs are moved together by bytes while they are not merged to single
+  // one.
+  const int* output_begin;
+  const int* output_end;
+  unsigned pos = begin;
+  for (; runs.size() > 1 && pos < end; ++pos) {
+    if (pos - begin == kMaxSpeculativeBytes) {
+      chunk->is_synchronized = false;
+      return;
+    }
+    next_runs.clear();
+    for (unsigned i = 0; i < runs.size(); ++i) {
+      Run& run = chunk->runs[runs[i]];
+      run.state = transducer_->GetByteTransition(run.state, data[pos],
+                                                 &output_begin, &output_end);
+      if (run.state == -1) {
+        continue;
+      }
+      run.symbols.insert(run.symbols.end(), output_begin, output_end);
+      int& state_run = states_runs[run.state];
+      if (state_run == -1) {
+        state_run = runs[i];
+        next_runs.push_back(runs[i]);
+      } else {
+        run.merged_run = state_run;
+        run.merge_offset = chunk->runs[state_run].symbols.size();
+      }
+    }
+    for (unsigned i = 0; i < next_runs.size(); ++i) {
+      states_runs[chunk->runs[next_runs[i]].state] = -1;
+    }
+    runs.swap(next_runs);
+  }
+
+  // The rest bytes are decoded by the left runs.
+  const unsigned n_rest_bits = (end - pos) * 8 + n_tail_bits;
+  const unsigned max_n_symbols = n_rest_bits +
+                                 transducer_->GetMaxNumberPending();
+  for (unsigned i = 0; i < runs.size(); ++i) {
+    Run& run = chunk->runs[runs[i]];
+    const unsigned n_symbols = run.symbols.size();
+    run.symbols.resize(n_symbols + max_n_symbols);
+    const int n_decoded = transducer_->Push(data + pos, n_rest_bits,
+                                            &run.state,
+                                            run.symbols.data() + n_symbols);
+    if (n_decoded == -1) {
+      run.state = -1;
+      run.symbols.resize(n_symbols);
+    } else {
+      run.symbols.resize(n_symbols + n_decoded);
+    }
+  }
+}
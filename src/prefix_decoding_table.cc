@@ -0,0 +1,77 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/prefix_decoding_table.h"
+
+#include <algorithm>
+
+PrefixDecodingTable::PrefixDecodingTable() {}
+
+void PrefixDecodingTable::Build(const CodeTree& code_tree,
+                                unsigned max_n_bits) {
+  const unsigned n_nodes = code_tree.GetNumberNodes();
+  // Children have greater ids than parents.
+  heights_.assign(n_nodes, 0);
+  for (int i = n_nodes - 1; i >= 0; --i) {
+    for (int j = 0; j < 2; ++j) {
+      const int child = code_tree.GetChild(i, j);
+      if (child != -1) {
+        heights_[i] = std::max(heights_[i], heights_[child] + 1);
+      }
+    }
+  }
+
+  entries_.clear();
+  tables_offsets_.clear();
+  tables_bits_.clear();
+  tables_nodes_.clear();
+  node_tables_.assign(n_nodes, -1);
+  if (heights_[0] == 0) {
+    return;
+  }
+  AddTable(0, max_n_bits);
+
+  // Tables are filled in order of adding, so list of tables is queue.
+  for (unsigned i = 0; i < tables_nodes_.size(); ++i) {
+    const int table_node = tables_nodes_[i];
+    const unsigned n_bits = tables_bits_[i];
+    for (unsigned bits = 0; bits < (1u << n_bits); ++bits) {
+      Entry entry;
+      entry.value = kInvalid;
+      entry.n_bits = n_bits;
+      int node = table_node;
+      for (unsigned j = 0; j < n_bits; ++j) {
+        node = code_tree.GetChild(node, (bits >> j) & 1);
+        if (node == -1) {
+          break;
+        }
+        ElementaryCode* elem_code = code_tree.GetElemCode(node);
+        if (elem_code) {
+          entry.value = elem_code->id;
+          entry.n_bits = j + 1;
+          break;
+        }
+      }
+      if (node != -1 && entry.value == kInvalid) {
+        int table = node_tables_[node];
+        if (table == -1) {
+          table = AddTable(node, max_n_bits);
+        }
+        entry.value = kNextTable - table;
+      }
+      entries_[tables_offsets_[i] + bits] = entry;
+    }
+  }
+}
+
+int PrefixDecodingTable::AddTable(int node, unsigned max_n_bits) {
+  const unsigned n_bits = std::min(max_n_bits, heights_[node]);
+  const int table = tables_nodes_.size();
+  tables_offsets_.push_back(entries_.size());
+  tables_bits_.push_back(n_bits);
+  tables_nodes_.push_back(node);
+  node_tables_[node] = table;
+  entries_.resize(entries_.size() + (1u << n_bits));
+  return table;
+}
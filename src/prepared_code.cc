@@ -0,0 +1,356 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/prepared_code.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <map>
+
+PreparedCodeBase::PreparedCodeBase()
+  : is_prefix_free_(true),
+    is_suffix_free_(true),
+    first_duplicate_id_(-1),
+    second_duplicate_id_(-1),
+    violates_mcmillan_inequality_(false),
+    n_removed_transitions_(0) {
+}
+
+template<int kRadix>
+BasicPreparedCode<kRadix>::BasicPreparedCode() {
+}
+
+template<int kRadix>
+BasicPreparedCode<kRadix>::BasicPreparedCode(
+    const std::vector<std::string>& code) {
+  Build(code);
+}
+
+template<int kRadix>
+void BasicPreparedCode<kRadix>::Build(const std::vector<std::string>& code) {
+  elem_codes_pool_.Rewind();
+  code_.resize(code.size());
+  for (unsigned i = 0; i < code.size(); ++i) {
+    ElementaryCode* elem_code = elem_codes_pool_.New();
+    elem_code->id = i;
+    elem_code->str = code[i];
+    Alphabet<kRadix>::Pack(elem_code);
+    elem_code->suffixes.clear();
+    code_[i] = elem_code;
+  }
+
+  // Select all suffixes.
+  suffix_tree_.Build(&code_);
+  suffix_tree_.GetSuffixes(&code_suffixes_);  // Includes empty suffix.
+
+  // Build code tree.
+  code_tree_.Build(code_);
+
+  CheckCodeProperties();
+  FindSuffixesRelations();
+  BuildDeficitsStateMachine();
+}
+
+template<int kRadix>
+void BasicPreparedCode<kRadix>::CheckCodeProperties() {
+  const unsigned n_codes = code_.size();
+  is_prefix_free_ = true;
+  is_suffix_free_ = true;
+  first_duplicate_id_ = -1;
+  second_duplicate_id_ = -1;
+  unsigned max_length = 0;
+  for (unsigned i = 0; i < n_codes; ++i) {
+    const typename Alphabet<kRadix>::Word& word =
+        Alphabet<kRadix>::GetWord(*code_[i]);
+    max_length = std::max(max_length, Alphabet<kRadix>::GetLength(word));
+
+    // Node keeps the last of equal codes.
+    const int node_id = code_tree_.Find(word);
+    unsigned lower_begin, lower_end;
+    code_tree_.GetLowerElemCodes(node_id, &lower_begin, &lower_end);
+    if (lower_end - lower_begin != 1) {
+      is_prefix_free_ = false;
+    }
+    ElementaryCode* node_elem_code = code_tree_.GetElemCode(node_id);
+    if (node_elem_code != code_[i] && first_duplicate_id_ == -1) {
+      first_duplicate_id_ = i;
+      second_duplicate_id_ = node_elem_code->id;
+    }
+
+    // The longest suffix is elementary code itself. It has other owners if
+    // it's suffix of other elementary codes.
+    if (code_[i]->suffixes[0]->owners.size() != 1) {
+      is_suffix_free_ = false;
+    }
+  }
+
+  // Exact sum of radix^(-length) from the longest codes. Value at level l is
+  // sum of radix^(l - length) by codes not shorter than l, it's kept as
+  // integer part and flag of nonzero fractional part. Integer part is not
+  // more than number of codes.
+  std::vector<unsigned> n_codes_by_length(max_length + 1, 0);
+  for (unsigned i = 0; i < n_codes; ++i) {
+    ++n_codes_by_length[code_[i]->str.size()];
+  }
+  uint64_t sum = 0;
+  bool has_fraction = false;
+  for (int length = max_length; length > 0; --length) {
+    sum += n_codes_by_length[length];
+    has_fraction |= (sum % kRadix) != 0;
+    sum /= kRadix;
+  }
+  sum += n_codes_by_length[0];
+  violates_mcmillan_inequality_ = sum > 1 || (sum == 1 && has_fraction);
+}
+
+const std::vector<ElementaryCode*>& PreparedCodeBase::GetElemCodes() const {
+  return code_;
+}
+
+const std::vector<Suffix*>& PreparedCodeBase::GetSuffixes() const {
+  return code_suffixes_;
+}
+
+const StateMachine& PreparedCodeBase::GetDeficitsStateMachine() const {
+  return deficits_state_machine_;
+}
+
+bool PreparedCodeBase::IsPrefixFree() const {
+  return is_prefix_free_;
+}
+
+bool PreparedCodeBase::IsSuffixFree() const {
+  return is_suffix_free_;
+}
+
+bool PreparedCodeBase::GetDuplicates(int* first_id, int* second_id) const {
+  *first_id = first_duplicate_id_;
+  *second_id = second_duplicate_id_;
+  return first_duplicate_id_ != -1;
+}
+
+bool PreparedCodeBase::ViolatesMcMillanInequality() const {
+  return violates_mcmillan_inequality_;
+}
+
+void PreparedCodeBase::BuildDeficitsStateMachine() {
+  // Let 0 state idx - identity deficit,
+  //   i<0 state idx - lower deficit lambda/alpha,
+  //                   where lambda is empty word,
+  //                   alpha - suffix with index |i|
+  //   i>0 state idx - upper deficit alpha/lambda,
+  //                   alpha index is |i|
+  const int n_deficits = code_suffixes_.size() * 2 - 1;
+  deficits_state_machine_.Init(n_deficits);
+  const int identity_deficit_id = UnsignedDeficitId(0);
+
+  std::vector<bool>& queued_deficits = queued_deficits_;
+  queued_deficits.assign(n_deficits, false);
+  // Identity deficit already processed.
+  queued_deficits[identity_deficit_id] = true;
+  events_stamps_.assign(code_.size(), ~0u);
+  n_removed_transitions_ = 0;
+
+  // Build deficits machine.
+  std::vector<int>& deficits_up_to_build = deficits_up_to_build_;
+  deficits_up_to_build.clear();
+  const int n_codes = code_.size();
+  for (int i = 0; i < n_codes; ++i) {
+    // Suffixes in descending order:
+    // for elementary code 01011
+    // [0]: 01011
+    // [1]: 1011
+    // ...
+    // [4]: 1
+    // [5]: empty suffix
+    int deficit_id = -code_[i]->suffixes[0]->id;
+    AddDeficitTransition(0, deficit_id, i, &deficits_up_to_build);
+  }
+
+  // Inductive building. Vector is used as queue: processed deficits are
+  // kept before head. Each deficit is queued once.
+  for (unsigned head = 0; head < deficits_up_to_build.size(); ++head) {
+    const int deficit_id = deficits_up_to_build[head];
+    AddAntitropicDeficits(deficit_id, &deficits_up_to_build);
+    AddIsotropicDeficits(deficit_id, &deficits_up_to_build);
+  }
+}
+
+void PreparedCodeBase::AddIsotropicDeficits(
+    int deficit_id, std::vector<int>* deficits_up_to_build) {
+  // Alpha = elem_code + beta.
+  // Find all elementary codes which are preffixes of alpha.
+  Suffix* alpha_suffix = code_suffixes_[abs(deficit_id)];
+  const std::vector<ElementaryCode*>& upper_elem_codes = upper_elem_codes_;
+  const unsigned begin = upper_elem_codes_offsets_[alpha_suffix->id];
+  const unsigned end = upper_elem_codes_offsets_[alpha_suffix->id + 1];
+  for (unsigned i = begin; i < end; ++i) {
+    int beta_suffix_idx = alpha_suffix->offset() +
+                          upper_elem_codes[i]->str.size();
+    Suffix* beta_suffix = alpha_suffix->owners[0]->suffixes[beta_suffix_idx];
+    int state_id = (deficit_id < 0 ? -beta_suffix->id : beta_suffix->id);
+    AddDeficitTransition(deficit_id, state_id, upper_elem_codes[i]->id,
+                         deficits_up_to_build);
+  }
+}
+
+void PreparedCodeBase::AddAntitropicDeficits(
+    int deficit_id, std::vector<int>* deficits_up_to_build) {
+  // Elem_code = alpha + beta.
+  // Find all elementary codes with prefix [alpha].
+  Suffix* alpha_suffix = code_suffixes_[abs(deficit_id)];
+  const std::vector<ElementaryCode*>& lower_elem_codes = lower_elem_codes_;
+  const unsigned begin = lower_elem_codes_begins_[alpha_suffix->id];
+  const unsigned end = lower_elem_codes_ends_[alpha_suffix->id];
+  for (unsigned i = begin; i < end; ++i) {
+    // Suffixes ordered from largest to minimal.
+    Suffix* beta_suffix = lower_elem_codes[i]->suffixes[alpha_suffix->length];
+
+    // Let identity deficit is an isotropic deficit.
+    if (beta_suffix->id != 0) {
+      int state_id = (deficit_id < 0 ? beta_suffix->id : -beta_suffix->id);
+      AddDeficitTransition(deficit_id, state_id, lower_elem_codes[i]->id,
+                           deficits_up_to_build);
+    }
+  }
+}
+
+template<int kRadix>
+void BasicPreparedCode<kRadix>::FindSuffixesRelations() {
+  const unsigned n_suffixes = code_suffixes_.size();
+  code_automaton_.Build(code_tree_);
+  lower_elem_codes_ = code_tree_.GetSortedElemCodes();
+  lower_elem_codes_begins_.assign(n_suffixes, 0);
+  lower_elem_codes_ends_.assign(n_suffixes, 0);
+
+  // Pairs (suffix id, elementary code which is prefix of suffix). Each
+  // suffix is processed at it's first owner only.
+  std::vector<std::pair<int, ElementaryCode*> >& relations = relations_buffer_;
+  relations.clear();
+  for (unsigned i = 0; i < code_.size(); ++i) {
+    ElementaryCode* elem_code = code_[i];
+    const typename Alphabet<kRadix>::Word& word =
+        Alphabet<kRadix>::GetWord(*elem_code);
+    const unsigned length = Alphabet<kRadix>::GetLength(word);
+    int state = 0;
+    for (unsigned pos = 0; pos < length; ++pos) {
+      state = code_automaton_.GetNextState(
+          state, Alphabet<kRadix>::GetSymbol(word, pos));
+      // Elementary codes which end at pos are prefixes of suffixes started
+      // at pos - code length + 1. Codes are found in order of positions, so
+      // prefixes of each suffix are ordered by length.
+      for (int output = code_automaton_.GetOutput(state); output != -1;
+           output = code_automaton_.GetOutput(
+               code_automaton_.GetFailure(output))) {
+        const unsigned depth = code_automaton_.GetDepth(output);
+        Suffix* suffix = elem_code->suffixes[pos + 1 - depth];
+        if (suffix->owners[0] == elem_code) {
+          // Equal elementary codes are the first codes of node's range.
+          unsigned codes_begin, codes_end;
+          code_tree_.GetLowerElemCodes(output, &codes_begin, &codes_end);
+          const std::vector<ElementaryCode*>& sorted_codes =
+              code_tree_.GetSortedElemCodes();
+          for (unsigned j = codes_begin; j < codes_end &&
+                                         sorted_codes[j]->str.size() == depth;
+               ++j) {
+            relations.push_back(std::make_pair(suffix->id, sorted_codes[j]));
+          }
+        }
+      }
+    }
+
+    // Suffixes which are prefixes of elementary codes are at failure links
+    // chain of the last state.
+    for (; state != 0; state = code_automaton_.GetFailure(state)) {
+      Suffix* suffix =
+          elem_code->suffixes[length - code_automaton_.GetDepth(state)];
+      if (suffix->owners[0] == elem_code) {
+        code_tree_.GetLowerElemCodes(state,
+                                     &lower_elem_codes_begins_[suffix->id],
+                                     &lower_elem_codes_ends_[suffix->id]);
+      }
+    }
+  }
+
+  // Stable counting sort by suffixes.
+  upper_elem_codes_offsets_.assign(n_suffixes + 1, 0);
+  for (unsigned i = 0; i < relations.size(); ++i) {
+    ++upper_elem_codes_offsets_[relations[i].first + 1];
+  }
+  for (unsigned i = 0; i < n_suffixes; ++i) {
+    upper_elem_codes_offsets_[i + 1] += upper_elem_codes_offsets_[i];
+  }
+  upper_elem_codes_.resize(relations.size());
+  for (unsigned i = 0; i < relations.size(); ++i) {
+    upper_elem_codes_[upper_elem_codes_offsets_[relations[i].first]++] =
+        relations[i].second;
+  }
+  // Offsets have been shifted by filling.
+  for (unsigned i = n_suffixes; i > 0; --i) {
+    upper_elem_codes_offsets_[i] = upper_elem_codes_offsets_[i - 1];
+  }
+  upper_elem_codes_offsets_[0] = 0;
+}
+
+void PreparedCodeBase::AddDeficitTransition(
+    int from_id, int to_id, int event_id,
+    std::vector<int>* deficits_up_to_build) {
+  const unsigned u_from_id = UnsignedDeficitId(from_id);
+  const unsigned u_to_id = UnsignedDeficitId(to_id);
+  // Transitions of each state are added one after another, so stamp shows
+  // that state already has transition by this event.
+  if (events_stamps_[event_id] == u_from_id) {
+    const std::vector<Transition*>& transitions =
+        deficits_state_machine_.GetState(u_from_id)->transitions;
+    for (unsigned i = 0; i < transitions.size(); ++i) {
+      if (transitions[i]->event_id == event_id &&
+          transitions[i]->to->id == u_to_id) {
+        ++n_removed_transitions_;
+        return;
+      }
+    }
+  }
+  events_stamps_[event_id] = u_from_id;
+
+  deficits_state_machine_.AddTransition(u_from_id, u_to_id, event_id);
+  if (!queued_deficits_[u_to_id]) {
+    queued_deficits_[u_to_id] = true;
+    deficits_up_to_build->push_back(to_id);
+  }
+}
+
+unsigned PreparedCodeBase::GetNumberRemovedTransitions() const {
+  return n_removed_transitions_;
+}
+
+void PreparedCodeBase::WriteDeficitsStateMachine(
+    const std::string& file_path) const {
+  // Set states names.
+  const int n_states = deficits_state_machine_.GetNumberStates();
+  std::vector<std::string> states_names(n_states);
+  states_names[UnsignedDeficitId(0)] = "\"\u03bb/\u03bb\"";
+
+  // First suffix if empty suffix, starts from 1.
+  const int n_suffixes = code_suffixes_.size();
+  for (int i = 1; i < n_suffixes; ++i) {
+    std::string str = code_suffixes_[i]->str();
+    states_names[UnsignedDeficitId(i)] = "\"" + str + "/\u03bb\"";
+    states_names[UnsignedDeficitId(-i)] = "\"\u03bb/" + str + "\"";
+  }
+
+  // Set transitions names.
+  std::map<int, std::string> events_names;
+  const int n_codes = code_.size();
+  for (int i = 0; i < n_codes; ++i) {
+    events_names[i] = code_[i]->str;
+  }
+  deficits_state_machine_.WriteDot(file_path, states_names, events_names);
+}
+
+template class BasicPreparedCode<2>;
+template class BasicPreparedCode<3>;
+template class BasicPreparedCode<4>;
+template class BasicPreparedCode<256>;
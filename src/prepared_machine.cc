@@ -0,0 +1,139 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/prepared_machine.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+
+const unsigned PreparedMachine::kMaxDenseNumberEvents = 64;
+const unsigned PreparedMachine::kMaxDenseTableSize = 1u << 24;
+
+static bool EventLess(const PreparedTransition& first,
+                      const PreparedTransition& second) {
+  return first.event < second.event;
+}
+
+static bool EventEqual(const PreparedTransition& first,
+                       const PreparedTransition& second) {
+  return first.event == second.event;
+}
+
+PreparedMachine::PreparedMachine()
+  : n_states_(0),
+    n_events_(0),
+    is_dense_(true) {
+}
+
+PreparedMachine::PreparedMachine(const StateMachine& state_machine) {
+  Build(state_machine);
+}
+
+void PreparedMachine::Build(const StateMachine& state_machine) {
+  n_states_ = state_machine.GetNumberStates();
+
+  // Outgoing transitions. Stable sorting keeps the first transition by event
+  // before others.
+  bool has_negative_events = false;
+  int max_event = -1;
+  out_offsets_.resize(n_states_ + 1);
+  out_transitions_.clear();
+  for (unsigned i = 0; i < n_states_; ++i) {
+    const std::vector<Transition*>& transitions =
+        state_machine.GetState(i)->transitions;
+    const unsigned begin = out_transitions_.size();
+    out_offsets_[i] = begin;
+    for (unsigned j = 0; j < transitions.size(); ++j) {
+      PreparedTransition trans;
+      trans.state = transitions[j]->to->id;
+      trans.event = transitions[j]->event_id;
+      has_negative_events |= trans.event < 0;
+      max_event = std::max(max_event, trans.event);
+      out_transitions_.push_back(trans);
+    }
+    std::stable_sort(out_transitions_.begin() + begin, out_transitions_.end(),
+                     EventLess);
+    out_transitions_.erase(std::unique(out_transitions_.begin() + begin,
+                                       out_transitions_.end(), EventEqual),
+                           out_transitions_.end());
+  }
+  out_offsets_[n_states_] = out_transitions_.size();
+
+  // Incoming transitions.
+  in_offsets_.assign(n_states_ + 1, 0);
+  for (unsigned i = 0; i < out_transitions_.size(); ++i) {
+    ++in_offsets_[out_transitions_[i].state + 1];
+  }
+  for (unsigned i = 0; i < n_states_; ++i) {
+    in_offsets_[i + 1] += in_offsets_[i];
+  }
+  in_transitions_.resize(out_transitions_.size());
+  for (unsigned i = 0; i < n_states_; ++i) {
+    for (unsigned j = out_offsets_[i]; j < out_offsets_[i + 1]; ++j) {
+      PreparedTransition& trans =
+          in_transitions_[in_offsets_[out_transitions_[j].state]++];
+      trans.state = i;
+      trans.event = out_transitions_[j].event;
+    }
+  }
+  // Offsets have been shifted by filling.
+  for (unsigned i = n_states_; i > 0; --i) {
+    in_offsets_[i] = in_offsets_[i - 1];
+  }
+  in_offsets_[0] = 0;
+
+  n_events_ = max_event + 1;
+  is_dense_ = !has_negative_events && n_events_ <= kMaxDenseNumberEvents &&
+              static_cast<uint64_t>(n_states_) * n_events_ <=
+              kMaxDenseTableSize;
+  if (is_dense_) {
+    dense_next_states_.assign(n_states_ * n_events_, -1);
+    for (unsigned i = 0; i < n_states_; ++i) {
+      for (unsigned j = out_offsets_[i]; j < out_offsets_[i + 1]; ++j) {
+        dense_next_states_[i * n_events_ + out_transitions_[j].event] =
+            out_transitions_[j].state;
+      }
+    }
+  } else {
+    dense_next_states_.clear();
+  }
+}
+
+unsigned PreparedMachine::GetNumberStates() const {
+  return n_states_;
+}
+
+const PreparedTransition* PreparedMachine::GetInTransitions(
+    unsigned state, unsigned* n_transitions) const {
+  *n_transitions = in_offsets_[state + 1] - in_offsets_[state];
+  return in_transitions_.data() + in_offsets_[state];
+}
+
+bool PreparedMachine::IsDense() const {
+  return is_dense_;
+}
+
+bool PreparedMachine::AcceptsAllWords(unsigned n_events) const {
+  if (n_states_ != 1) {
+    return false;
+  }
+  for (unsigned i = 0; i < n_events; ++i) {
+    if (GetNextState(0, i) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int PreparedMachine::FindNextState(unsigned state, int event) const {
+  PreparedTransition key;
+  key.event = event;
+  std::vector<PreparedTransition>::const_iterator end =
+      out_transitions_.begin() + out_offsets_[state + 1];
+  std::vector<PreparedTransition>::const_iterator it =
+      std::lower_bound(out_transitions_.begin() + out_offsets_[state], end,
+                       key, EventLess);
+  return (it != end && it->event == event ? it->state : -1);
+}
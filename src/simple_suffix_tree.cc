@@ -6,38 +6,49 @@
 
 #include <string>
 
-void SimpleSuffixTree::Build(std::vector<ElementaryCode*>* code) {
+template<int kRadix>
+void BasicSimpleSuffixTree<kRadix>::Build(
+    std::vector<ElementaryCode*>* code) {
+  typedef typename Alphabet<kRadix>::Word Word;
+
+  Clear();
+
   // Add root.
-  Suffix* empty_suffix = new Suffix(0, 0);
+  Suffix* empty_suffix = NewSuffix(0, 0);
   suffixes_.push_back(empty_suffix);
   vertices_content_.push_back(empty_suffix);
-  childs_[0].push_back(-1);
-  childs_[1].push_back(-1);
+  childs_.resize(kRadix, -1);
 
-  // For each suffix we try find corresponding node. If node not found, we
-  // create it.
-  for (int i = 0; i < code->size(); ++i) {
+  // Reversed code is added to tree. Vertices at it's path are suffixes, if
+  // vertex is new, suffix is new too.
+  for (unsigned i = 0; i < code->size(); ++i) {
     ElementaryCode* elem_code = (*code)[i];
     elem_code->suffixes.clear();
-    std::string word = elem_code->str;
-    for (int j = 0; j < word.size(); ++j) {
-      int current_vertex = 0;
-      for (int k = j; k < word.size(); ++k) {
-        int symbol = word[k] - '0';
-        if (childs_[symbol][current_vertex] == -1) {
-          childs_[symbol][current_vertex] = childs_[symbol].size();
-          current_vertex = childs_[symbol].size();
-          childs_[symbol].push_back(-1);
-          childs_[1 - symbol].push_back(-1);
-          vertices_content_.push_back(0);
-        } else {
-          current_vertex = childs_[symbol][current_vertex];
-        }
+    const Word& word = Alphabet<kRadix>::GetWord(*elem_code);
+    const int length = Alphabet<kRadix>::GetLength(word);
+    path_.resize(length + 1);
+    int current_vertex = 0;
+    for (int k = 1; k <= length; ++k) {
+      const int child_idx = current_vertex * kRadix +
+                            Alphabet<kRadix>::GetSymbol(word, length - k);
+      if (childs_[child_idx] == -1) {
+        current_vertex = vertices_content_.size();
+        childs_[child_idx] = current_vertex;
+        childs_.resize(childs_.size() + kRadix, -1);
+        vertices_content_.push_back(0);
+      } else {
+        current_vertex = childs_[child_idx];
       }
+      path_[k] = current_vertex;
+    }
+
+    // From the longest suffix.
+    for (int j = 0; j < length; ++j) {
+      current_vertex = path_[length - j];
       if (!vertices_content_[current_vertex]) {
-        vertices_content_[current_vertex] = new Suffix(suffixes_.size(),
-                                                       word.size() - j,
-                                                       elem_code);
+        vertices_content_[current_vertex] = NewSuffix(suffixes_.size(),
+                                                     length - j,
+                                                     elem_code);
         suffixes_.push_back(vertices_content_[current_vertex]);
       } else {
         vertices_content_[current_vertex]->owners.push_back(elem_code);
@@ -45,24 +56,43 @@ void SimpleSuffixTree::Build(std::vector<ElementaryCode*>* code) {
       elem_code->suffixes.push_back(vertices_content_[current_vertex]);
     }
   }
-  for (int i = 0; i < code->size(); ++i) {
+  for (unsigned i = 0; i < code->size(); ++i) {
     (*code)[i]->suffixes.push_back(empty_suffix);
     empty_suffix->owners.push_back((*code)[i]);
   }
 }
 
-void SimpleSuffixTree::GetSuffixes(std::vector<Suffix*>* suffixes) {
+template<int kRadix>
+void BasicSimpleSuffixTree<kRadix>::GetSuffixes(
+    std::vector<Suffix*>* suffixes) {
   suffixes->clear();
-  for (int i = 0; i < suffixes_.size(); ++i) {
+  for (unsigned i = 0; i < suffixes_.size(); ++i) {
     suffixes->push_back(suffixes_[i]);
   }
 }
 
-void SimpleSuffixTree::Clear() {
-  childs_[0].clear();
-  childs_[1].clear();
-  for (int i = 0; i < suffixes_.size(); ++i) {
-    delete suffixes_[i];
-  }
+template<int kRadix>
+void BasicSimpleSuffixTree<kRadix>::Clear() {
+  childs_.clear();
+  vertices_content_.clear();
   suffixes_.clear();
+  suffixes_pool_.Rewind();
 }
+
+template<int kRadix>
+Suffix* BasicSimpleSuffixTree<kRadix>::NewSuffix(
+    int id, int length, ElementaryCode* first_owner) {
+  Suffix* suffix = suffixes_pool_.New();
+  suffix->id = id;
+  suffix->length = length;
+  suffix->owners.clear();
+  if (first_owner) {
+    suffix->owners.push_back(first_owner);
+  }
+  return suffix;
+}
+
+template class BasicSimpleSuffixTree<2>;
+template class BasicSimpleSuffixTree<3>;
+template class BasicSimpleSuffixTree<4>;
+template class BasicSimpleSuffixTree<256>;
@@ -4,6 +4,7 @@
 
 #include "include/state_machine.h"
 
+#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -22,41 +23,37 @@ StateMachine::~StateMachine() {
 }
 
 void StateMachine::Init(int n_states) {
-  if (!states_.empty()) {
-    Clear();
-  }
+  Clear();
 
   // Add states.
-  states_.resize(n_states);
   for (int i = 0; i < n_states; ++i) {
-    states_[i] = new State(i);
+    State* state = states_.New();
+    state->id = i;
+    state->transitions.clear();
+    state->in_transitions.clear();
   }
 }
 
 void StateMachine::Clear() {
-  int n_states = states_.size();
-  for (int i = 0; i < n_states; ++i) {
-    delete states_[i];
-  }
-  states_.clear();
-
-  int n_transitions = transitions_.size();
-  for (int i = 0; i < n_transitions; ++i) {
-    delete transitions_[i];
-  }
-  transitions_.clear();
+  states_.Rewind();
+  transitions_.Rewind();
 }
 
 void StateMachine::AddTransition(unsigned from_id, unsigned to_id,
                                  int event_id) {
-  Transition* trans = new Transition(transitions_.size(),
-                                     states_[from_id],
-                                     states_[to_id],
-                                     event_id);
-  transitions_.push_back(trans);
+  Transition* trans = transitions_.New();
+  trans->id = transitions_.size() - 1;
+  trans->from = states_[from_id];
+  trans->to = states_[to_id];
+  trans->event_id = event_id;
+  trans->from->transitions.push_back(trans);
+  trans->to->in_transitions.push_back(trans);
 }
 
 State* StateMachine::GetState(int id) const {
+  // Pool keeps rewound states after Clear() so index past size isn't caught
+  // by vector.
+  assert(0 <= id && static_cast<unsigned>(id) < states_.size());
   return states_[id];
 }
 
@@ -128,7 +125,7 @@ bool StateMachine::IsRecognized(const std::vector<int>& word) const {
       return false;
     }
   }
-  return state == states_.back();
+  return state == states_[states_.size() - 1];
 }
 
 void StateMachine::WriteConfig(std::ofstream* s) const {
@@ -0,0 +1,342 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/stream_decoder.h"
+
+#include <algorithm>
+
+const unsigned StreamDecoder::kMaxTableBits = 12;
+
+StreamDecoder::StreamDecoder()
+  : n_states_(0), max_n_pending_(0), is_table_driven_(false),
+    accepts_all_words_(false), is_transducer_driven_(false),
+    transducer_state_(DecodingTransducer::kStartState),
+    n_hypotheses_(0), n_next_hypotheses_(0), stamp_(0), is_failed_(true) {}
+
+bool StreamDecoder::Init(const std::vector<std::string>& code,
+                         const StateMachine& code_state_machine,
+                         unsigned max_n_transducer_states) {
+  is_failed_ = true;
+  for (unsigned i = 0; i < code.size(); ++i) {
+    if (code[i].empty()) {
+      return false;
+    }
+  }
+  prepared_code_.Build(code);
+  prepared_machine_.Build(code_state_machine);
+  int first_duplicate_id, second_duplicate_id;
+  if (prepared_code_.GetDuplicates(&first_duplicate_id,
+                                   &second_duplicate_id) ||
+      !checker_.IsBijective(prepared_code_, prepared_machine_)) {
+    return false;
+  }
+  unsigned n_delay_codes, n_delay_bits;
+  if (!delay_analyzer_.Analyze(prepared_code_, prepared_machine_,
+                               &n_delay_codes, &n_delay_bits)) {
+    return false;
+  }
+  // Hypothesis keeps codes of one of two parsings and the next one.
+  max_n_pending_ = n_delay_codes + 1;
+
+  code_tree_.Build(prepared_code_.GetElemCodes());
+  const unsigned n_nodes = code_tree_.GetNumberNodes();
+  childs_.resize(2 * n_nodes);
+  node_codes_.resize(n_nodes);
+  for (unsigned i = 0; i < n_nodes; ++i) {
+    childs_[2 * i] = code_tree_.GetChild(i, 0);
+    childs_[2 * i + 1] = code_tree_.GetChild(i, 1);
+    ElementaryCode* elem_code = code_tree_.GetElemCode(i);
+    node_codes_[i] = (elem_code ? elem_code->id : -1);
+  }
+
+  n_states_ = prepared_machine_.GetNumberStates();
+  DecodingTransducer::FindNextCodes(code_tree_, prepared_machine_,
+                                    &has_next_codes_);
+
+  is_table_driven_ = prepared_code_.IsPrefixFree();
+  accepts_all_words_ = prepared_machine_.AcceptsAllWords(code.size());
+  if (is_table_driven_) {
+    prefix_table_.Build(code_tree_, kMaxTableBits);
+  }
+  is_transducer_driven_ = !is_table_driven_ &&
+                          max_n_transducer_states != 0 &&
+                          transducer_.Build(code_tree_, prepared_machine_,
+                                            has_next_codes_,
+                                            max_n_transducer_states);
+
+  const unsigned max_n_hypotheses = n_nodes * n_states_;
+  nodes_.resize(max_n_hypotheses);
+  states_.resize(max_n_hypotheses);
+  n_pending_.resize(max_n_hypotheses);
+  pending_.resize(max_n_hypotheses * max_n_pending_);
+  next_nodes_.resize(max_n_hypotheses);
+  next_states_.resize(max_n_hypotheses);
+  next_n_pending_.resize(max_n_hypotheses);
+  next_pending_.resize(max_n_hypotheses * max_n_pending_);
+  stamps_.assign(max_n_hypotheses, 0);
+  stamp_ = 0;
+  Reset();
+  return true;
+}
+
+void StreamDecoder::Reset() {
+  nodes_[0] = 0;
+  states_[0] = 0;
+  n_pending_[0] = 0;
+  n_hypotheses_ = 1;
+  transducer_state_ = DecodingTransducer::kStartState;
+  is_failed_ = false;
+}
+
+int StreamDecoder::Push(const uint8_t* data, unsigned n_bits, int* symbols) {
+  if (is_failed_) {
+    return -1;
+  }
+  if (is_table_driven_) {
+    return PushByTables(data, n_bits, symbols);
+  }
+  if (is_transducer_driven_) {
+    const int n_symbols = transducer_.Push(data, n_bits, &transducer_state_,
+                                           symbols);
+    is_failed_ = n_symbols == -1;
+    return n_symbols;
+  }
+  int n_symbols = 0;
+  for (unsigned i = 0; i < n_bits; ++i) {
+    const int bit = (data[i >> 3] >> (i & 7)) & 1;
+    if (n_hypotheses_ == 1 && n_pending_[0] == 0) {
+      // Single hypothesis is moved in place while it doesn't branch.
+      const int node = childs_[2 * nodes_[0] + bit];
+      if (node == -1) {
+        is_failed_ = true;
+        return -1;
+      }
+      const int state = states_[0];
+      const int code_id = node_codes_[node];
+      const int next_state = (code_id != -1 ?
+          prepared_machine_.GetNextState(state, code_id) : -1);
+      const bool has_next_codes = has_next_codes_[node * n_states_ + state];
+      if (next_state == -1 && has_next_codes) {
+        nodes_[0] = node;
+        continue;
+      }
+      if (next_state != -1 && !has_next_codes) {
+        symbols[n_symbols++] = code_id;
+        nodes_[0] = 0;
+        states_[0] = next_state;
+        continue;
+      }
+    }
+    if (!Step(bit)) {
+      is_failed_ = true;
+      return -1;
+    }
+    n_symbols += Commit(symbols + n_symbols);
+  }
+  return n_symbols;
+}
+
+int StreamDecoder::Finish(int* symbols) {
+  if (is_failed_) {
+    return -1;
+  }
+  if (is_transducer_driven_) {
+    const int n_symbols = transducer_.Finish(transducer_state_, symbols);
+    Reset();
+    return n_symbols;
+  }
+  const int final_state = n_states_ - 1;
+  for (unsigned i = 0; i < n_hypotheses_; ++i) {
+    if (nodes_[i] == 0 && states_[i] == final_state) {
+      const int* pending = &pending_[i * max_n_pending_];
+      std::copy(pending, pending + n_pending_[i], symbols);
+      const int n_symbols = n_pending_[i];
+      Reset();
+      return n_symbols;
+    }
+  }
+  Reset();
+  return -1;
+}
+
+unsigned StreamDecoder::GetMaxNumberPending() const {
+  return (is_transducer_driven_ ? transducer_.GetMaxNumberPending() :
+                                  max_n_pending_);
+}
+
+bool StreamDecoder::IsTableDriven() const {
+  return is_table_driven_;
+}
+
+bool StreamDecoder::IsTransducerDriven() const {
+  return is_transducer_driven_;
+}
+
+int StreamDecoder::PushByTables(const uint8_t* data, unsigned n_bits,
+                                int* symbols) {
+  int node = nodes_[0];
+  int state = states_[0];
+  int n_symbols = 0;
+  // Bits [pos, pos + n_buffered) are kept by buffer from the least
+  // significant bit. Buffer may keep bits after n_bits.
+  uint64_t buffer = 0;
+  unsigned n_buffered = 0;
+  unsigned next_byte = 0;
+  const unsigned n_bytes = (n_bits + 7) / 8;
+  const int root_table = prefix_table_.GetTable(0);
+  const PrefixDecodingTable::Entry* root_entries =
+      (root_table != -1 ? prefix_table_.GetEntries(root_table) : 0);
+  const unsigned n_root_bits = (root_table != -1 ?
+                                prefix_table_.GetNumberBits(root_table) : 0);
+  const uint64_t root_mask = (1ull << n_root_bits) - 1;
+  for (unsigned pos = 0; pos < n_bits;) {
+    while (n_buffered <= 56 && next_byte < n_bytes) {
+      buffer |= static_cast<uint64_t>(data[next_byte++]) << n_buffered;
+      n_buffered += 8;
+    }
+    if (node == 0 && accepts_all_words_ && root_entries) {
+      // Codes of root table are decoded without tracking of state until
+      // buffer ends.
+      const unsigned n_available = std::min(n_buffered, n_bits - pos);
+      unsigned n_read = 0;
+      while (n_read + n_root_bits <= n_available) {
+        const PrefixDecodingTable::Entry entry = root_entries[buffer &
+                                                              root_mask];
+        if (entry.value < 0) {
+          break;
+        }
+        symbols[n_symbols++] = entry.value;
+        buffer >>= entry.n_bits;
+        n_read += entry.n_bits;
+      }
+      n_buffered -= n_read;
+      pos += n_read;
+      if (n_read != 0) {
+        continue;
+      }
+    }
+    int code_id = -1;
+    const int table = prefix_table_.GetTable(node);
+    if (table != -1 &&
+        prefix_table_.GetNumberBits(table) <= std::min(n_buffered,
+                                                       n_bits - pos)) {
+      const uint64_t mask = (1ull << prefix_table_.GetNumberBits(table)) - 1;
+      const PrefixDecodingTable::Entry& entry =
+          prefix_table_.Lookup(table, buffer & mask);
+      if (entry.value == PrefixDecodingTable::kInvalid) {
+        is_failed_ = true;
+        return -1;
+      }
+      buffer >>= entry.n_bits;
+      n_buffered -= entry.n_bits;
+      pos += entry.n_bits;
+      if (entry.value >= 0) {
+        code_id = entry.value;
+      } else {
+        node = prefix_table_.GetNode(PrefixDecodingTable::kNextTable -
+                                     entry.value);
+      }
+    } else {
+      // Stream ends before the table's bits.
+      node = childs_[2 * node + (buffer & 1)];
+      buffer >>= 1;
+      --n_buffered;
+      ++pos;
+      if (node == -1) {
+        is_failed_ = true;
+        return -1;
+      }
+      code_id = node_codes_[node];
+    }
+    if (code_id != -1) {
+      if (!accepts_all_words_) {
+        state = prepared_machine_.GetNextState(state, code_id);
+        if (state == -1) {
+          is_failed_ = true;
+          return -1;
+        }
+      }
+      symbols[n_symbols++] = code_id;
+      node = 0;
+    }
+  }
+  nodes_[0] = node;
+  states_[0] = state;
+  return n_symbols;
+}
+
+bool StreamDecoder::Step(int bit) {
+  if (++stamp_ == 0) {
+    std::fill(stamps_.begin(), stamps_.end(), 0);
+    stamp_ = 1;
+  }
+  n_next_hypotheses_ = 0;
+  for (unsigned i = 0; i < n_hypotheses_; ++i) {
+    const int node = childs_[2 * nodes_[i] + bit];
+    if (node == -1) {
+      continue;
+    }
+    const int code_id = node_codes_[node];
+    if (code_id != -1) {
+      const int state = prepared_machine_.GetNextState(states_[i], code_id);
+      if (state != -1) {
+        AddHypothesis(0, state, i, code_id);
+      }
+    }
+    if (has_next_codes_[node * n_states_ + states_[i]]) {
+      AddHypothesis(node, states_[i], i, -1);
+    }
+  }
+  nodes_.swap(next_nodes_);
+  states_.swap(next_states_);
+  n_pending_.swap(next_n_pending_);
+  pending_.swap(next_pending_);
+  n_hypotheses_ = n_next_hypotheses_;
+  return n_hypotheses_ != 0;
+}
+
+void StreamDecoder::AddHypothesis(int node, int state, int idx, int code_id) {
+  const unsigned key = node * n_states_ + state;
+  if (stamps_[key] == stamp_) {
+    return;
+  }
+  stamps_[key] = stamp_;
+
+  const unsigned next_idx = n_next_hypotheses_++;
+  next_nodes_[next_idx] = node;
+  next_states_[next_idx] = state;
+  const int* pending = &pending_[idx * max_n_pending_];
+  int* next_pending = &next_pending_[next_idx * max_n_pending_];
+  unsigned n_pending = n_pending_[idx];
+  std::copy(pending, pending + n_pending, next_pending);
+  if (code_id != -1) {
+    next_pending[n_pending++] = code_id;
+  }
+  next_n_pending_[next_idx] = n_pending;
+}
+
+int StreamDecoder::Commit(int* symbols) {
+  int n_symbols = 0;
+  while (true) {
+    if (n_pending_[0] == 0) {
+      break;
+    }
+    const int code_id = pending_[0];
+    bool is_agreed = true;
+    for (unsigned i = 1; i < n_hypotheses_ && is_agreed; ++i) {
+      is_agreed = n_pending_[i] != 0 &&
+                  pending_[i * max_n_pending_] == code_id;
+    }
+    if (!is_agreed) {
+      break;
+    }
+    symbols[n_symbols++] = code_id;
+    for (unsigned i = 0; i < n_hypotheses_; ++i) {
+      int* pending = &pending_[i * max_n_pending_];
+      std::copy(pending + 1, pending + n_pending_[i], pending);
+      --n_pending_[i];
+    }
+  }
+  return n_symbols;
+}
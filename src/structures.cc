@@ -12,7 +12,8 @@
 
 ElementaryCode::ElementaryCode(int id, const std::string& str)
   : id(id),
-    str(str) {
+    str(str),
+    bits(str) {
 }
 
 Suffix::Suffix(int id, int length,
@@ -25,7 +26,7 @@ Suffix::Suffix(int id, int length,
 }
 
 std::string Suffix::str() {
-  return owners[0]->str.substr(owners[0]->str.length() - length);
+  return owners[0]->str.substr(offset(), length);
 }
 
 Transition::Transition(unsigned id, State* from, State *to, int event_id)
@@ -34,6 +35,7 @@ Transition::Transition(unsigned id, State* from, State *to, int event_id)
     event_id(event_id),
     id(id) {
   from->transitions.push_back(this);
+  to->in_transitions.push_back(this);
 }
 
 Transition* State::GetTransition(int event_id) {
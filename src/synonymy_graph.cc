@@ -0,0 +1,180 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/synonymy_graph.h"
+
+#include "include/synonymy_step.h"
+
+SynonymyGraph::SynonymyGraph()
+  : n_deficits_(0),
+    n_code_sm_states_(0),
+    identity_deficit_id_(0),
+    end_node_(-1) {
+}
+
+void SynonymyGraph::Build(const PreparedCodeBase& code,
+                          const PreparedMachine& code_machine) {
+  const StateMachine& deficits = code.GetDeficitsStateMachine();
+  const unsigned n_codes = code.GetElemCodes().size();
+  n_deficits_ = deficits.GetNumberStates();
+  n_code_sm_states_ = code_machine.GetNumberStates();
+  identity_deficit_id_ = code.UnsignedDeficitId(0);
+  const unsigned kEndCodeSmState = n_code_sm_states_ - 1;
+
+  nodes_.clear();
+  offsets_.assign(1, 0);
+  edges_.clear();
+  end_node_ = -1;
+  nodes_ids_.Init(static_cast<uint64_t>(n_deficits_) * n_code_sm_states_ *
+                  n_code_sm_states_ * 2 +
+                  static_cast<uint64_t>(n_codes) * n_code_sm_states_);
+
+  Node node;
+  node.deficit = deficits.GetState(identity_deficit_id_);
+  node.upper_state = 0;
+  node.lower_state = 0;
+  node.leaving_code = -1;
+  node.is_tivial = true;
+  nodes_.push_back(node);
+  nodes_ids_.Set(Key(node), 0);
+
+  // Edges are added node by node in order of queue.
+  for (unsigned head = 0; head < nodes_.size(); ++head) {
+    node = nodes_[head];
+    State* deficit = node.deficit;
+    const bool is_identity = deficit->id == identity_deficit_id_;
+    const bool lower_moves =
+        SynonymyStep::LowerMoves(code.SignedDeficitId(deficit->id));
+    const int code_state = (lower_moves ? node.lower_state :
+                                          node.upper_state);
+    for (unsigned i = 0; i < deficit->transitions.size(); ++i) {
+      Transition* def_trans = deficit->transitions[i];
+      const int event = def_trans->event_id;
+      const int to = code_machine.GetNextState(code_state, event);
+      if (to == -1) {
+        continue;
+      }
+      Node next_node = node;
+      next_node.deficit = def_trans->to;
+      if (lower_moves) {
+        next_node.lower_state = to;
+      } else {
+        next_node.upper_state = to;
+      }
+      const bool next_is_identity =
+          def_trans->to->id == identity_deficit_id_;
+      next_node.is_tivial = SynonymyStep::IsTrivial(
+          node.is_tivial, is_identity, next_is_identity, event,
+          node.leaving_code);
+      next_node.leaving_code = SynonymyStep::LeavingCode(
+          next_node.is_tivial, next_is_identity, event);
+
+      const uint64_t key = Key(next_node);
+      int id = nodes_ids_.Get(key);
+      if (id == -1) {
+        id = nodes_.size();
+        nodes_ids_.Set(key, id);
+        nodes_.push_back(next_node);
+        if (!next_node.is_tivial && next_is_identity &&
+            next_node.upper_state == static_cast<int>(kEndCodeSmState) &&
+            next_node.lower_state == static_cast<int>(kEndCodeSmState)) {
+          end_node_ = id;
+        }
+      }
+      Edge edge;
+      edge.to = id;
+      edge.symbol = SynonymyStep::Symbol(lower_moves, event);
+      edges_.push_back(edge);
+    }
+    offsets_.push_back(edges_.size());
+  }
+}
+
+unsigned SynonymyGraph::GetNumberNodes() const {
+  return nodes_.size();
+}
+
+const SynonymyGraph::Node& SynonymyGraph::GetNode(int id) const {
+  return nodes_[id];
+}
+
+const SynonymyGraph::Edge* SynonymyGraph::GetEdges(int id,
+                                                   unsigned* n_edges) const {
+  *n_edges = offsets_[id + 1] - offsets_[id];
+  return edges_.data() + offsets_[id];
+}
+
+int SynonymyGraph::GetEndNode() const {
+  return end_node_;
+}
+
+void SynonymyGraph::RemoveUselessNodes(std::vector<bool>* is_useful) {
+  const unsigned n_nodes = nodes_.size();
+  is_useful->assign(n_nodes, false);
+  if (end_node_ == -1) {
+    offsets_.assign(n_nodes + 1, 0);
+    edges_.clear();
+    return;
+  }
+
+  // Reversed edges.
+  std::vector<unsigned> in_offsets(n_nodes + 1, 0);
+  for (unsigned i = 0; i < edges_.size(); ++i) {
+    ++in_offsets[edges_[i].to + 1];
+  }
+  for (unsigned i = 0; i < n_nodes; ++i) {
+    in_offsets[i + 1] += in_offsets[i];
+  }
+  std::vector<int> in_nodes(edges_.size());
+  std::vector<unsigned> in_fill(in_offsets.begin(), in_offsets.end() - 1);
+  for (unsigned i = 0; i < n_nodes; ++i) {
+    for (unsigned j = offsets_[i]; j < offsets_[i + 1]; ++j) {
+      in_nodes[in_fill[edges_[j].to]++] = i;
+    }
+  }
+
+  // Backward breadth-first search from end node.
+  std::vector<int> queue(1, end_node_);
+  (*is_useful)[end_node_] = true;
+  for (unsigned head = 0; head < queue.size(); ++head) {
+    const int id = queue[head];
+    for (unsigned i = in_offsets[id]; i < in_offsets[id + 1]; ++i) {
+      if (!(*is_useful)[in_nodes[i]]) {
+        (*is_useful)[in_nodes[i]] = true;
+        queue.push_back(in_nodes[i]);
+      }
+    }
+  }
+
+  // Keep edges between useful nodes only.
+  unsigned n_edges = 0;
+  unsigned begin = 0;
+  for (unsigned i = 0; i < n_nodes; ++i) {
+    const unsigned end = offsets_[i + 1];
+    offsets_[i] = n_edges;
+    if ((*is_useful)[i]) {
+      for (unsigned j = begin; j < end; ++j) {
+        if ((*is_useful)[edges_[j].to]) {
+          edges_[n_edges++] = edges_[j];
+        }
+      }
+    }
+    begin = end;
+  }
+  offsets_[n_nodes] = n_edges;
+  edges_.resize(n_edges);
+}
+
+uint64_t SynonymyGraph::Key(const Node& node) const {
+  const uint64_t n_product_keys = static_cast<uint64_t>(n_deficits_) *
+                                  n_code_sm_states_ * n_code_sm_states_ * 2;
+  if (node.leaving_code != -1) {
+    return n_product_keys +
+           static_cast<uint64_t>(node.leaving_code) * n_code_sm_states_ +
+           node.upper_state;
+  }
+  return ((static_cast<uint64_t>(node.deficit->id) * n_code_sm_states_ +
+           node.upper_state) * n_code_sm_states_ + node.lower_state) * 2 +
+         !node.is_tivial;
+}
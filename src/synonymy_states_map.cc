@@ -0,0 +1,237 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/synonymy_states_map.h"
+
+const uint64_t SynonymyStatesMap::kMaxDenseNumberStates = 1ull << 26;
+const unsigned SynonymyStatesMap::kInitialHashCapacity = 1024;
+const uint64_t SynonymyStatesMap::kEmptyKey = ~0ull;
+const uint64_t SynonymyStatesIndex::kMaxDenseNumberStates = 1ull << 22;
+const unsigned SynonymyStatesIndex::kInitialHashCapacity = 1024;
+const uint64_t SynonymyStatesIndex::kEmptyKey = ~0ull;
+
+static const uint64_t kEmptyClaimKey = ~0ull;
+
+// Finalizer of splitmix64.
+static inline uint64_t Mix(uint64_t x) {
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+  return x ^ (x >> 31);
+}
+
+SynonymyStatesMap::SynonymyStatesMap()
+  : is_dense_(true),
+    n_keys_(0) {
+}
+
+void SynonymyStatesMap::Init(uint64_t n_states) {
+  is_dense_ = n_states <= kMaxDenseNumberStates;
+  if (is_dense_) {
+    dense_values_.assign((n_states + 31) / 32, 0);
+  } else {
+    keys_.assign(kInitialHashCapacity, kEmptyKey);
+    values_.assign(kInitialHashCapacity, 0);
+    n_keys_ = 0;
+  }
+}
+
+unsigned char SynonymyStatesMap::Get(uint64_t state) const {
+  if (is_dense_) {
+    return (dense_values_[state >> 5] >> ((state & 31) << 1)) & 3;
+  } else {
+    return values_[FindSlot(state)];
+  }
+}
+
+void SynonymyStatesMap::Set(uint64_t state, unsigned char value) {
+  if (is_dense_) {
+    const unsigned shift = (state & 31) << 1;
+    uint64_t& word = dense_values_[state >> 5];
+    word = (word & ~(3ull << shift)) | (static_cast<uint64_t>(value) << shift);
+  } else {
+    unsigned slot = FindSlot(state);
+    if (keys_[slot] == kEmptyKey) {
+      if (value == 0) {
+        return;
+      }
+      if (2 * (n_keys_ + 1) > keys_.size()) {
+        Rehash(2 * keys_.size());
+        slot = FindSlot(state);
+      }
+      keys_[slot] = state;
+      ++n_keys_;
+    }
+    values_[slot] = value;
+  }
+}
+
+bool SynonymyStatesMap::IsDense() const {
+  return is_dense_;
+}
+
+void SynonymyStatesMap::Reserve(unsigned n_new_states) {
+  if (!is_dense_) {
+    unsigned capacity = keys_.size();
+    while (2 * (n_keys_ + n_new_states) > capacity) {
+      capacity *= 2;
+    }
+    if (capacity != keys_.size()) {
+      Rehash(capacity);
+    }
+  }
+}
+
+void SynonymyStatesMap::SetBitsConcurrently(uint64_t state,
+                                            unsigned char bits) {
+  if (is_dense_) {
+    __atomic_fetch_or(&dense_values_[state >> 5],
+                      static_cast<uint64_t>(bits) << ((state & 31) << 1),
+                      __ATOMIC_RELAXED);
+  } else {
+    const unsigned mask = keys_.size() - 1;
+    unsigned slot = Mix(state) & mask;
+    while (true) {
+      uint64_t key = __atomic_load_n(&keys_[slot], __ATOMIC_RELAXED);
+      if (key == kEmptyKey) {
+        if (__atomic_compare_exchange_n(&keys_[slot], &key, state, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+          __atomic_fetch_add(&n_keys_, 1, __ATOMIC_RELAXED);
+          break;
+        }
+        // Other thread has taken this slot. Key is updated by it's value.
+      }
+      if (key == state) {
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+    __atomic_fetch_or(&values_[slot], bits, __ATOMIC_RELAXED);
+  }
+}
+
+unsigned SynonymyStatesMap::FindSlot(uint64_t state) const {
+  const unsigned mask = keys_.size() - 1;
+  unsigned slot = Mix(state) & mask;
+  while (keys_[slot] != state && keys_[slot] != kEmptyKey) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void SynonymyStatesMap::Rehash(unsigned capacity) {
+  // Previous table is kept to reuse it's memory at next rehash.
+  keys_.swap(old_keys_);
+  values_.swap(old_values_);
+  keys_.assign(capacity, kEmptyKey);
+  values_.assign(capacity, 0);
+  for (unsigned i = 0; i < old_keys_.size(); ++i) {
+    if (old_keys_[i] != kEmptyKey) {
+      const unsigned slot = FindSlot(old_keys_[i]);
+      keys_[slot] = old_keys_[i];
+      values_[slot] = old_values_[i];
+    }
+  }
+}
+
+SynonymyStatesIndex::SynonymyStatesIndex()
+  : is_dense_(true),
+    n_keys_(0) {
+}
+
+void SynonymyStatesIndex::Init(uint64_t n_states) {
+  is_dense_ = n_states <= kMaxDenseNumberStates;
+  if (is_dense_) {
+    dense_ids_.assign(n_states, -1);
+  } else {
+    keys_.assign(kInitialHashCapacity, kEmptyKey);
+    ids_.assign(kInitialHashCapacity, -1);
+    n_keys_ = 0;
+  }
+}
+
+int SynonymyStatesIndex::Get(uint64_t state) const {
+  return (is_dense_ ? dense_ids_[state] : ids_[FindSlot(state)]);
+}
+
+void SynonymyStatesIndex::Set(uint64_t state, int id) {
+  if (is_dense_) {
+    dense_ids_[state] = id;
+    return;
+  }
+  unsigned slot = FindSlot(state);
+  if (keys_[slot] == kEmptyKey) {
+    if (2 * (n_keys_ + 1) > keys_.size()) {
+      Rehash(2 * keys_.size());
+      slot = FindSlot(state);
+    }
+    keys_[slot] = state;
+    ++n_keys_;
+  }
+  ids_[slot] = id;
+}
+
+unsigned SynonymyStatesIndex::FindSlot(uint64_t state) const {
+  const unsigned mask = keys_.size() - 1;
+  unsigned slot = Mix(state) & mask;
+  while (keys_[slot] != state && keys_[slot] != kEmptyKey) {
+    slot = (slot + 1) & mask;
+  }
+  return slot;
+}
+
+void SynonymyStatesIndex::Rehash(unsigned capacity) {
+  keys_.swap(old_keys_);
+  ids_.swap(old_ids_);
+  keys_.assign(capacity, kEmptyKey);
+  ids_.assign(capacity, -1);
+  for (unsigned i = 0; i < old_keys_.size(); ++i) {
+    if (old_keys_[i] != kEmptyKey) {
+      const unsigned slot = FindSlot(old_keys_[i]);
+      keys_[slot] = old_keys_[i];
+      ids_[slot] = old_ids_[i];
+    }
+  }
+}
+
+void SynonymyClaimsTable::Init(unsigned n_states) {
+  unsigned capacity = 16;
+  while (capacity < 2 * n_states) {
+    capacity *= 2;
+  }
+  keys_.assign(capacity, kEmptyClaimKey);
+  ranks_.assign(2 * capacity, ~0u);
+}
+
+void SynonymyClaimsTable::Claim(uint64_t state, int kind, unsigned rank) {
+  const unsigned mask = keys_.size() - 1;
+  unsigned slot = Mix(state) & mask;
+  while (true) {
+    uint64_t key = __atomic_load_n(&keys_[slot], __ATOMIC_RELAXED);
+    if (key == kEmptyClaimKey &&
+        __atomic_compare_exchange_n(&keys_[slot], &key, state, false,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+      break;
+    }
+    if (key == state) {
+      break;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  unsigned* min_rank = &ranks_[2 * slot + kind];
+  unsigned current = __atomic_load_n(min_rank, __ATOMIC_RELAXED);
+  while (rank < current &&
+         !__atomic_compare_exchange_n(min_rank, &current, rank, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+  }
+}
+
+unsigned SynonymyClaimsTable::GetRank(uint64_t state, int kind) const {
+  const unsigned mask = keys_.size() - 1;
+  unsigned slot = Mix(state) & mask;
+  while (keys_[slot] != state && keys_[slot] != kEmptyClaimKey) {
+    slot = (slot + 1) & mask;
+  }
+  return keys_[slot] == state ? ranks_[2 * slot + kind] : ~0u;
+}
@@ -0,0 +1,137 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/thread_pool.h"
+
+#include <stdint.h>
+
+ThreadPool::ThreadPool(int n_threads)
+  : generation_(0),
+    n_busy_workers_(0),
+    stop_(false),
+    task_(0),
+    ranges_(n_threads > 1 ? n_threads : 1) {
+  for (int i = 1; i < n_threads; ++i) {
+    threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  start_cv_.notify_all();
+  for (unsigned i = 0; i < threads_.size(); ++i) {
+    threads_[i].join();
+  }
+}
+
+int ThreadPool::GetNumberThreads() const {
+  return threads_.size() + 1;
+}
+
+void ThreadPool::Run(int n_tasks, const std::function<void(int, int)>& task) {
+  if (threads_.empty() || n_tasks == 1) {
+    for (int i = 0; i < n_tasks; ++i) {
+      task(i, 0);
+    }
+    return;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    task_ = &task;
+    const int n_threads = ranges_.size();
+    for (int i = 0; i < n_threads; ++i) {
+      ranges_[i].begin = static_cast<int64_t>(n_tasks) * i / n_threads;
+      ranges_[i].end = static_cast<int64_t>(n_tasks) * (i + 1) / n_threads;
+    }
+    n_busy_workers_ = threads_.size();
+    ++generation_;
+  }
+  start_cv_.notify_all();
+
+  RunTasks(0);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (n_busy_workers_ != 0) {
+    done_cv_.wait(lock);
+  }
+}
+
+void ThreadPool::WorkerLoop(int thread_id) {
+  unsigned generation = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (!stop_ && generation == generation_) {
+        start_cv_.wait(lock);
+      }
+      if (stop_) {
+        return;
+      }
+      generation = generation_;
+    }
+
+    RunTasks(thread_id);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (--n_busy_workers_ == 0) {
+      done_cv_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::RunTasks(int thread_id) {
+  TasksRange& range = ranges_[thread_id];
+  do {
+    while (true) {
+      int task_id;
+      {
+        std::unique_lock<std::mutex> lock(range.mutex);
+        if (range.begin == range.end) {
+          break;
+        }
+        task_id = range.begin++;
+      }
+      (*task_)(task_id, thread_id);
+    }
+  } while (StealTasks(thread_id));
+}
+
+bool ThreadPool::StealTasks(int thread_id) {
+  while (true) {
+    // Ranges may change after choosing so victim range is checked again.
+    int victim = -1;
+    int max_n_tasks = 0;
+    for (unsigned i = 0; i < ranges_.size(); ++i) {
+      std::unique_lock<std::mutex> lock(ranges_[i].mutex);
+      const int n_tasks = ranges_[i].end - ranges_[i].begin;
+      if (n_tasks > max_n_tasks) {
+        max_n_tasks = n_tasks;
+        victim = i;
+      }
+    }
+    if (victim == -1) {
+      return false;
+    }
+
+    int begin, end;
+    {
+      std::unique_lock<std::mutex> lock(ranges_[victim].mutex);
+      const int n_tasks = ranges_[victim].end - ranges_[victim].begin;
+      if (n_tasks == 0) {
+        continue;  // Victim has finished it's tasks. Choose another one.
+      }
+      end = ranges_[victim].end;
+      begin = end - (n_tasks + 1) / 2;
+      ranges_[victim].end = begin;
+    }
+    std::unique_lock<std::mutex> lock(ranges_[thread_id].mutex);
+    ranges_[thread_id].begin = begin;
+    ranges_[thread_id].end = end;
+    return true;
+  }
+}
@@ -0,0 +1,81 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include "include/witness_enumerator.h"
+
+#include <algorithm>
+
+WitnessEnumerator::WitnessEnumerator()
+  : code_(0),
+    code_machine_(0),
+    head_(0) {
+}
+
+void WitnessEnumerator::Init(const PreparedCodeBase& code,
+                             const PreparedMachine& code_machine) {
+  code_ = &code;
+  code_machine_ = &code_machine;
+  graph_.Build(code, code_machine);
+  graph_.RemoveUselessNodes(&is_useful_);
+
+  paths_.clear();
+  head_ = 0;
+  if (is_useful_[0]) {
+    Path path;
+    path.state = 0;
+    path.parent = -1;
+    path.symbol = 0;
+    paths_.push_back(path);
+  }
+}
+
+bool WitnessEnumerator::Next(std::vector<int>* first_word,
+                             std::vector<int>* second_word) {
+  first_word->clear();
+  second_word->clear();
+  while (head_ < paths_.size()) {
+    const unsigned path_idx = head_++;
+    const int state = paths_[path_idx].state;
+    unsigned n_edges;
+    const SynonymyGraph::Edge* edges = graph_.GetEdges(state, &n_edges);
+    for (unsigned i = 0; i < n_edges; ++i) {
+      Path path;
+      path.state = edges[i].to;
+      path.parent = path_idx;
+      path.symbol = edges[i].symbol;
+      paths_.push_back(path);
+    }
+    if (state == graph_.GetEndNode()) {
+      ExtractWords(path_idx, first_word, second_word);
+      // Mirrored witness is reached by path of the same length where the
+      // other word reads the first code after each agreement point.
+      if (*second_word < *first_word) {
+        first_word->clear();
+        second_word->clear();
+        continue;
+      }
+      return true;
+    }
+  }
+  return false;
+}
+
+unsigned WitnessEnumerator::GetNumberStates() const {
+  return std::count(is_useful_.begin(), is_useful_.end(), true);
+}
+
+void WitnessEnumerator::ExtractWords(int path_idx,
+                                     std::vector<int>* first_word,
+                                     std::vector<int>* second_word) {
+  for (; path_idx != -1; path_idx = paths_[path_idx].parent) {
+    const int symbol = paths_[path_idx].symbol;
+    if (symbol > 0) {
+      first_word->push_back(symbol - 1);
+    } else if (symbol < 0) {
+      second_word->push_back(-symbol - 1);
+    }
+  }
+  std::reverse(first_word->begin(), first_word->end());
+  std::reverse(second_word->begin(), second_word->end());
+}
@@ -0,0 +1,146 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/alphabetic_encoder.h"
+#include "include/code_generator.h"
+#include "include/state_machine.h"
+#include "include/structures.h"
+
+// Random word of elementary codes. It's recognized by state machine if
+// is_recognized, otherwise it may be any word.
+static void GenWord(const StateMachine& state_machine, int n_codes,
+                    int length, bool is_recognized, std::vector<int>* word) {
+  word->clear();
+  State* state = state_machine.GetState(0);
+  for (int i = 0; i < length; ++i) {
+    if (!is_recognized) {
+      word->push_back(rand() % n_codes);
+      continue;
+    }
+    const std::vector<Transition*>& transitions = state->transitions;
+    if (transitions.empty()) {
+      break;
+    }
+    Transition* transition = transitions[rand() % transitions.size()];
+    // The first transition by event is used.
+    transition = state->GetTransition(transition->event_id);
+    word->push_back(transition->event_id);
+    state = transition->to;
+  }
+}
+
+// Encoded bits are concatenation of elementary codes.
+TEST(AlphabeticEncoder, encode) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxWordLength = 100;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  std::vector<int> word;
+  std::vector<uint8_t> data;
+  int n_encoded_words = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 10);
+    // Long codes are written by several words.
+    const int max_length = (i % 2 ? 8 : 150);
+    code.resize(n_codes);
+    for (int j = 0; j < n_codes; ++j) {
+      code[j].resize(rand(1, max_length));
+      for (int k = 0; k < code[j].size(); ++k) {
+        code[j][k] = '0' + rand() % 2;
+      }
+    }
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+    AlphabeticEncoder encoder(code, state_machine);
+
+    GenWord(state_machine, n_codes, rand(0, kMaxWordLength), i % 3 != 0,
+            &word);
+    uint64_t n_bits;
+    const bool is_encoded = encoder.Encode(word.data(), word.size(), &data,
+                                           &n_bits);
+    ASSERT_EQ(is_encoded, state_machine.IsRecognized(word));
+    if (!is_encoded) {
+      continue;
+    }
+    std::string bits = "";
+    for (int j = 0; j < word.size(); ++j) {
+      bits += code[word[j]];
+    }
+    ASSERT_EQ(n_bits, bits.size());
+    ASSERT_EQ(data.size(), (bits.size() + 7) / 8);
+    for (int j = 0; j < bits.size(); ++j) {
+      ASSERT_EQ((data[j / 8] >> (j % 8)) & 1, bits[j] - '0');
+    }
+    ++n_encoded_words;
+  }
+  ASSERT_NE(n_encoded_words, 0);
+
+  // Unknown symbols.
+  AlphabeticEncoder encoder(code, state_machine);
+  word.assign(1, code.size());
+  uint64_t n_bits;
+  ASSERT_FALSE(encoder.Encode(word.data(), word.size(), &data, &n_bits));
+  word[0] = -1;
+  ASSERT_FALSE(encoder.Encode(word.data(), word.size(), &data, &n_bits));
+}
+
+// Long words are encoded by chunks in parallel the same as by single thread.
+TEST(AlphabeticEncoder, encode_concurrently) {
+  static const int kNumberGenerations = 20;
+  static const int kWordLength = 100000;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  std::vector<int> word;
+  std::vector<uint8_t> data;
+  std::vector<uint8_t> concurrent_data;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 10);
+    const int max_length = (i % 2 ? 8 : 150);
+    code.resize(n_codes);
+    for (int j = 0; j < n_codes; ++j) {
+      code[j].resize(rand(1, max_length));
+      for (int k = 0; k < code[j].size(); ++k) {
+        code[j][k] = '0' + rand() % 2;
+      }
+    }
+    // Large machines are checked sequentially.
+    CodeGenerator::GenStateMachine(n_codes, (i % 4 ? rand(1, 3) : 12),
+                                   &state_machine);
+    AlphabeticEncoder encoder(code, state_machine);
+    AlphabeticEncoder concurrent_encoder(code, state_machine);
+    concurrent_encoder.SetNumberThreads(rand(2, 4));
+
+    GenWord(state_machine, n_codes, rand(1, kWordLength), i % 3 != 0, &word);
+    uint64_t n_bits;
+    uint64_t n_concurrent_bits;
+    const bool is_encoded = encoder.Encode(word.data(), word.size(), &data,
+                                           &n_bits);
+    // Output buffer may be dirty.
+    concurrent_data.assign(rand(0, 1000), 0xff);
+    ASSERT_EQ(concurrent_encoder.Encode(word.data(), word.size(),
+                                        &concurrent_data, &n_concurrent_bits),
+              is_encoded);
+    if (is_encoded) {
+      ASSERT_EQ(n_concurrent_bits, n_bits);
+      ASSERT_EQ(concurrent_data, data);
+    }
+
+    // Unknown symbol.
+    if (word.empty()) {
+      continue;
+    }
+    word[rand() % word.size()] = n_codes;
+    ASSERT_FALSE(concurrent_encoder.Encode(word.data(), word.size(),
+                                           &concurrent_data,
+                                           &n_concurrent_bits));
+  }
+}
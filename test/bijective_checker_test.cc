@@ -2,16 +2,27 @@
 // License: MIT License (see LICENSE)
 // e-mail: dmitry.kurtaev@gmail.com
 
+#include <math.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
 #include <vector>
 #include <sstream>
 #include <string>
 
 #include <gtest/gtest.h>
 
+#include "include/alphabet.h"
+#include "include/batch_bijective_checker.h"
 #include "include/bijective_checker.h"
 #include "include/code_generator.h"
+#include "include/decoding_delay_analyzer.h"
+#include "include/incremental_bijective_checker.h"
+#include "include/static_bijective_checker.h"
 #include "include/structures.h"
 #include "include/unbijective_code_generator.h"
+#include "include/witness_enumerator.h"
 #include "test/macros.h"
 
 static const unsigned kNumberGenerations = 25;
@@ -200,3 +211,932 @@ TEST(BijectiveChecker, not_bijective_codes) {
     ASSERT_FALSE(checker.IsBijective(code, state_machine));
   }
 }
+
+// Words are recognized, different and have the same encoding.
+static bool AreSynonyms(const std::vector<std::string>& code,
+                        const StateMachine& state_machine,
+                        const std::vector<int>& first_word,
+                        const std::vector<int>& second_word) {
+  std::string first_bits = "";
+  for (int i = 0; i < first_word.size(); ++i) {
+    first_bits += code[first_word[i]];
+  }
+  std::string second_bits = "";
+  for (int i = 0; i < second_word.size(); ++i) {
+    second_bits += code[second_word[i]];
+  }
+  return first_word != second_word && first_bits == second_bits &&
+         state_machine.IsRecognized(first_word) &&
+         state_machine.IsRecognized(second_word);
+}
+
+// Search of synonyms by all words up to max_length elementary codes.
+static bool HasShortSynonyms(const std::vector<std::string>& code,
+                             const StateMachine& state_machine,
+                             int max_length) {
+  std::map<std::string, std::vector<int> > encoded_words;
+  std::vector<int> word;
+  for (int length = 1; length <= max_length; ++length) {
+    word.assign(length, 0);
+    while (true) {
+      if (state_machine.IsRecognized(word)) {
+        std::string bits = "";
+        for (int i = 0; i < length; ++i) {
+          bits += code[word[i]];
+        }
+        if (encoded_words.count(bits) != 0) {
+          return true;
+        }
+        encoded_words[bits] = word;
+      }
+      int i = 0;
+      while (i < length && ++word[i] == code.size()) {
+        word[i++] = 0;
+      }
+      if (i == length) {
+        break;
+      }
+    }
+  }
+  return false;
+}
+
+// Equal elementary codes are different paths of synonymy state machine
+// which return to identity deficit. Code state machine may distinguish
+// them, so they are checked by search.
+TEST(BijectiveChecker, duplicate_codes) {
+  static const int kNumberGenerations = 3000;
+  static const int kMaxWordLength = 4;
+
+  std::vector<std::string> code(2, "0");
+  StateMachine state_machine(2);
+  state_machine.AddTransition(0, 1, 0);
+  state_machine.AddTransition(0, 1, 1);
+  BijectiveChecker checker;
+  BijectiveChecker multithreaded_checker;
+  multithreaded_checker.SetNumberThreads(2);
+  BijectiveChecker bidirectional_checker;
+  bidirectional_checker.SetBidirectionalSearch(true);
+  std::vector<BijectiveChecker*> checkers;
+  checkers.push_back(&checker);
+  checkers.push_back(&multithreaded_checker);
+  checkers.push_back(&bidirectional_checker);
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  for (int i = 0; i < checkers.size(); ++i) {
+    ASSERT_FALSE(checkers[i]->IsBijective(code, state_machine,
+                                          &first_bad_word, &second_bad_word));
+    ASSERT_TRUE(AreSynonyms(code, state_machine, first_bad_word,
+                            second_bad_word));
+  }
+
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int N = rand(2, 5);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, N),
+                                CodeGenerator::MaxCodeLength(4, N)),
+                           4, N, &code);
+    code[rand() % N] = code[rand() % N];
+    CodeGenerator::GenStateMachine(N, rand(1, 4), &state_machine);
+    const bool has_synonyms = HasShortSynonyms(code, state_machine,
+                                               kMaxWordLength);
+    for (int j = 0; j < checkers.size(); ++j) {
+      const bool is_bijective = checkers[j]->IsBijective(code, state_machine,
+                                                         &first_bad_word,
+                                                         &second_bad_word);
+      if (has_synonyms) {
+        ASSERT_FALSE(is_bijective);
+      }
+      if (!is_bijective) {
+        ASSERT_TRUE(AreSynonyms(code, state_machine, first_bad_word,
+                                second_bad_word));
+      }
+    }
+  }
+}
+
+// Checker keeps its memory between checks. Test that reused checker gives
+// same results as new one.
+TEST(BijectiveChecker, reused_checker) {
+  static const int kNumberGenerations = 1000;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  BijectiveChecker reused_checker;
+  std::vector<int> first_bad_word[2];
+  std::vector<int> second_bad_word[2];
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    if (i % 2) {
+      UnbijectiveCodeGenerator::Generate(&code, &state_machine);
+    } else {
+      CodeGenerator::GenPrefixCode(4, 6, &code);
+      CodeGenerator::GenStateMachine(6, 3, &state_machine);
+    }
+    BijectiveChecker checker;
+    ASSERT_EQ(reused_checker.IsBijective(code, state_machine,
+                                         &first_bad_word[0],
+                                         &second_bad_word[0]),
+              checker.IsBijective(code, state_machine, &first_bad_word[1],
+                                  &second_bad_word[1]));
+    ASSERT_EQ(first_bad_word[0], first_bad_word[1]);
+    ASSERT_EQ(second_bad_word[0], second_bad_word[1]);
+  }
+}
+
+// Product of deficits state machine and two code state machines has more
+// than 2^32 states here but only few of them are reachable.
+TEST(BijectiveChecker, huge_code_state_machine) {
+  static const int kNumberStates = 70000;
+
+  StateMachine state_machine(kNumberStates);
+  state_machine.AddTransition(0, 0, 0);
+  for (int i = 0; i < 3; ++i) {
+    state_machine.AddTransition(0, kNumberStates - 1, i);
+    state_machine.AddTransition(kNumberStates - 1, kNumberStates - 1, i);
+  }
+
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  std::vector<std::string> code;
+  code.push_back("0");
+  code.push_back("10");
+  code.push_back("11");
+  ASSERT_TRUE(checker.IsBijective(code, state_machine));
+
+  code[2] = "01";
+  code[1] = "1";
+  ASSERT_FALSE(checker.IsBijective(code, state_machine, &first_bad_word,
+                                   &second_bad_word));
+  ASSERT_TRUE(state_machine.IsRecognized(first_bad_word));
+  ASSERT_TRUE(state_machine.IsRecognized(second_bad_word));
+  ASSERT_NE(first_bad_word, second_bad_word);
+}
+
+// Compare bidirectional search with forward one.
+TEST(BijectiveChecker, bidirectional_search) {
+  static const int kNumberGenerations = 3000;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  BijectiveChecker checker;
+  BijectiveChecker bidirectional_checker;
+  bidirectional_checker.SetBidirectionalSearch(true);
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  std::vector<int> forward_first_bad_word;
+  std::vector<int> forward_second_bad_word;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    if (i % 2) {
+      UnbijectiveCodeGenerator::Generate(&code, &state_machine);
+    } else {
+      const int N = rand(2, 6);
+      CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, N),
+                                  CodeGenerator::MaxCodeLength(4, N)),
+                             4, N, &code);
+      CodeGenerator::GenStateMachine(N, rand(1, 4), &state_machine);
+    }
+    bool is_bijective = checker.IsBijective(code, state_machine,
+                                            &forward_first_bad_word,
+                                            &forward_second_bad_word);
+    ASSERT_EQ(bidirectional_checker.IsBijective(code, state_machine,
+                                                &first_bad_word,
+                                                &second_bad_word),
+              is_bijective);
+    if (!is_bijective) {
+      // Both searches find the shortest loop.
+      ASSERT_EQ(first_bad_word.size() + second_bad_word.size(),
+                forward_first_bad_word.size() + forward_second_bad_word.size());
+      ASSERT_NE(first_bad_word, second_bad_word);
+      ASSERT_TRUE(state_machine.IsRecognized(first_bad_word));
+      ASSERT_TRUE(state_machine.IsRecognized(second_bad_word));
+
+      std::string first_word = "";
+      for (int j = 0; j < first_bad_word.size(); ++j) {
+        first_word += code[first_bad_word[j]];
+      }
+      std::string second_word = "";
+      for (int j = 0; j < second_bad_word.size(); ++j) {
+        second_word += code[second_bad_word[j]];
+      }
+      ASSERT_EQ(first_word, second_word);
+    }
+  }
+}
+
+// Concurrent search finds the same words as single thread one.
+TEST(BijectiveChecker, multithreaded_search) {
+  static const int kNumberStates = 300;
+  static const int kMaxNumberThreads = 4;
+
+  std::vector<std::string> code;
+  code.push_back("0");
+  code.push_back("01");
+  code.push_back("11");
+  code.push_back("110");
+
+  // Many states of product are reachable so levels of search are big.
+  StateMachine state_machine(kNumberStates);
+  for (int i = 0; i < kNumberStates; ++i) {
+    for (int j = 0; j < code.size(); ++j) {
+      state_machine.AddTransition(i, (i * 3 + j + 1) % kNumberStates, j);
+    }
+  }
+
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  ASSERT_FALSE(checker.IsBijective(code, state_machine, &first_bad_word,
+                                   &second_bad_word));
+  for (int n_threads = 2; n_threads <= kMaxNumberThreads; ++n_threads) {
+    BijectiveChecker multithreaded_checker;
+    multithreaded_checker.SetNumberThreads(n_threads);
+    std::vector<int> mt_first_bad_word;
+    std::vector<int> mt_second_bad_word;
+    ASSERT_FALSE(multithreaded_checker.IsBijective(code, state_machine,
+                                                   &mt_first_bad_word,
+                                                   &mt_second_bad_word));
+    ASSERT_EQ(mt_first_bad_word, first_bad_word);
+    ASSERT_EQ(mt_second_bad_word, second_bad_word);
+
+    code.pop_back();
+    ASSERT_TRUE(multithreaded_checker.IsBijective(code, state_machine));
+    code.push_back("110");
+  }
+}
+
+// Batch check by several threads gives the same results as single checker.
+TEST(BijectiveChecker, batch_check) {
+  static const int kNumberProblems = 500;
+  static const int kNumberThreads = 4;
+
+  std::vector<std::vector<std::string> > codes(kNumberProblems);
+  std::vector<StateMachine> state_machines(kNumberProblems);
+  std::vector<BijectivityProblem> problems(kNumberProblems);
+  for (int i = 0; i < kNumberProblems; ++i) {
+    if (i % 2) {
+      UnbijectiveCodeGenerator::Generate(&codes[i], &state_machines[i]);
+    } else {
+      const int N = rand(2, 6);
+      CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, N),
+                                  CodeGenerator::MaxCodeLength(4, N)),
+                             4, N, &codes[i]);
+      CodeGenerator::GenStateMachine(N, rand(1, 4), &state_machines[i]);
+    }
+    problems[i] = BijectivityProblem(&codes[i], &state_machines[i]);
+  }
+
+  BatchBijectiveChecker batch_checker(kNumberThreads);
+  std::vector<BijectivityResult> results;
+  std::vector<BijectivityResult> results_without_words;
+  batch_checker.IsBijective(problems, true, &results);
+  batch_checker.IsBijective(problems, false, &results_without_words);
+  ASSERT_EQ(results.size(), kNumberProblems);
+  ASSERT_EQ(results_without_words.size(), kNumberProblems);
+
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  for (int i = 0; i < kNumberProblems; ++i) {
+    const bool is_bijective = checker.IsBijective(codes[i], state_machines[i],
+                                                  &first_bad_word,
+                                                  &second_bad_word);
+    ASSERT_EQ(results[i].is_bijective, is_bijective);
+    ASSERT_EQ(results[i].first_bad_word, first_bad_word);
+    ASSERT_EQ(results[i].second_bad_word, second_bad_word);
+    ASSERT_EQ(results_without_words[i].is_bijective, is_bijective);
+    ASSERT_TRUE(results_without_words[i].first_bad_word.empty());
+  }
+}
+
+// Code prepared once is checked with many state machines, also concurrently.
+TEST(BijectiveChecker, prepared_code) {
+  static const int kNumberCodes = 50;
+  static const int kNumberStateMachines = 20;
+  static const int kNumberThreads = 4;
+
+  std::vector<std::string> code;
+  std::vector<StateMachine> state_machines(kNumberStateMachines);
+  std::vector<BijectivityProblem> problems(kNumberStateMachines);
+  std::vector<BijectivityResult> results;
+  BijectiveChecker checker;
+  BatchBijectiveChecker batch_checker(kNumberThreads);
+  PreparedCode prepared_code;
+  std::vector<int> first_bad_word[2];
+  std::vector<int> second_bad_word[2];
+  for (int i = 0; i < kNumberCodes; ++i) {
+    const int N = rand(2, 6);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, N),
+                                CodeGenerator::MaxCodeLength(4, N)),
+                           4, N, &code);
+    prepared_code.Build(code);
+    for (int j = 0; j < kNumberStateMachines; ++j) {
+      CodeGenerator::GenStateMachine(N, rand(1, 4), &state_machines[j]);
+      problems[j] = BijectivityProblem(&prepared_code, &state_machines[j]);
+    }
+    batch_checker.IsBijective(problems, true, &results);
+
+    for (int j = 0; j < kNumberStateMachines; ++j) {
+      const bool is_bijective = checker.IsBijective(code, state_machines[j],
+                                                    &first_bad_word[0],
+                                                    &second_bad_word[0]);
+      ASSERT_EQ(checker.IsBijective(prepared_code, state_machines[j],
+                                    &first_bad_word[1], &second_bad_word[1]),
+                is_bijective);
+      ASSERT_EQ(first_bad_word[1], first_bad_word[0]);
+      ASSERT_EQ(second_bad_word[1], second_bad_word[0]);
+      ASSERT_EQ(results[j].is_bijective, is_bijective);
+      ASSERT_EQ(results[j].first_bad_word, first_bad_word[0]);
+      ASSERT_EQ(results[j].second_bad_word, second_bad_word[0]);
+    }
+  }
+}
+
+// Prepared machine finds the same transitions as state machine for small
+// (dense table) and large (sorted transitions) alphabets.
+TEST(BijectiveChecker, prepared_machine) {
+  static const int kNumberGenerations = 100;
+  static const int kMaxNumberStates = 10;
+  static const int kMaxNumberEvents = 200;
+
+  StateMachine state_machine;
+  PreparedMachine prepared_machine;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_states = rand(1, kMaxNumberStates);
+    const int n_events = (i % 2 ? rand(1, 10) : rand(100, kMaxNumberEvents));
+    state_machine.Init(n_states);
+    // Table size is defined by the greatest event.
+    state_machine.AddTransition(rand(0, n_states - 1), rand(0, n_states - 1),
+                                n_events - 1);
+    for (int j = 0, n = rand(0, n_states * n_events); j < n; ++j) {
+      state_machine.AddTransition(rand(0, n_states - 1),
+                                  rand(0, n_states - 1),
+                                  rand(0, n_events - 1));
+    }
+    prepared_machine.Build(state_machine);
+    ASSERT_EQ(prepared_machine.IsDense(), i % 2 == 1);
+    ASSERT_EQ(prepared_machine.GetNumberStates(), n_states);
+
+    int n_in_transitions = 0;
+    for (int state = 0; state < n_states; ++state) {
+      for (int event = -1; event <= n_events; ++event) {
+        Transition* trans = state_machine.GetState(state)
+                                         ->GetTransition(event);
+        ASSERT_EQ(prepared_machine.GetNextState(state, event),
+                  trans ? trans->to->id : -1);
+        n_in_transitions -= (trans != 0);
+      }
+      unsigned n_transitions;
+      const PreparedTransition* in_transitions =
+          prepared_machine.GetInTransitions(state, &n_transitions);
+      for (unsigned j = 0; j < n_transitions; ++j) {
+        ASSERT_EQ(prepared_machine.GetNextState(in_transitions[j].state,
+                                                in_transitions[j].event),
+                  state);
+      }
+      n_in_transitions += n_transitions;
+    }
+    ASSERT_EQ(n_in_transitions, 0);
+  }
+
+  // Single prepared machine is used for many codes.
+  std::vector<std::string> code;
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word[2];
+  std::vector<int> second_bad_word[2];
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    if (i % 10 == 0) {
+      CodeGenerator::GenStateMachine(4, rand(1, 4), &state_machine);
+      prepared_machine.Build(state_machine);
+    }
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, 4),
+                                CodeGenerator::MaxCodeLength(4, 4)),
+                           4, 4, &code);
+    PreparedCode prepared_code(code);
+    ASSERT_EQ(checker.IsBijective(prepared_code, prepared_machine,
+                                  &first_bad_word[0], &second_bad_word[0]),
+              checker.IsBijective(code, state_machine, &first_bad_word[1],
+                                  &second_bad_word[1]));
+    ASSERT_EQ(first_bad_word[0], first_bad_word[1]);
+    ASSERT_EQ(second_bad_word[0], second_bad_word[1]);
+  }
+}
+
+// Cheap checks of code properties give the same results as synonymy loop
+// search.
+TEST(BijectiveChecker, check_tiers) {
+  static const int kNumberGenerations = 300;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int N = rand(2, 6);
+    CodeGenerator::GenPrefixCode(5, N, &code);
+    CodeGenerator::GenStateMachine(N, rand(1, 4), &state_machine);
+    ASSERT_TRUE(checker.IsBijective(code, state_machine));
+    ASSERT_EQ(checker.GetLastCheckTier(), BijectiveChecker::PREFIX_FREE_TIER);
+
+    // Reversed prefix code is suffix code.
+    for (int j = 0; j < N; ++j) {
+      std::reverse(code[j].begin(), code[j].end());
+    }
+    ASSERT_TRUE(checker.IsBijective(code, state_machine));
+    ASSERT_TRUE(checker.GetLastCheckTier() ==
+                BijectiveChecker::PREFIX_FREE_TIER ||
+                checker.GetLastCheckTier() ==
+                BijectiveChecker::SUFFIX_FREE_TIER);
+
+    // Equal elementary codes.
+    StateMachineOfAllWords(N + 1, state_machine);
+    const int duplicate_id = rand(0, N - 1);
+    code.push_back(code[duplicate_id]);
+    ASSERT_FALSE(checker.IsBijective(code, state_machine, &first_bad_word,
+                                     &second_bad_word));
+    ASSERT_EQ(checker.GetLastCheckTier(), BijectiveChecker::DUPLICATES_TIER);
+    ASSERT_EQ(first_bad_word, std::vector<int>(1, duplicate_id));
+    ASSERT_EQ(second_bad_word, std::vector<int>(1, N));
+
+    // McMillan's inequality.
+    const int M = rand(2, 4);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(M, N),
+                                CodeGenerator::MaxCodeLength(M, N)),
+                           M, N, &code);
+    StateMachineOfAllWords(N, state_machine);
+    const bool is_bijective = checker.IsBijective(code, state_machine,
+                                                  &first_bad_word,
+                                                  &second_bad_word);
+    ASSERT_EQ(checker.IsBijective(code, state_machine), is_bijective);
+    double sum = 0;
+    for (int j = 0; j < N; ++j) {
+      sum += pow(2.0, -static_cast<double>(code[j].length()));
+    }
+    if (checker.GetLastCheckTier() == BijectiveChecker::MCMILLAN_TIER) {
+      ASSERT_GT(sum, 1);
+    } else if (sum > 1) {
+      ASSERT_FALSE(is_bijective);
+    }
+  }
+}
+
+// Deficits state machine has no repeated transitions.
+TEST(BijectiveChecker, unique_deficits_transitions) {
+  static const int kNumberGenerations = 300;
+
+  std::vector<std::string> code;
+  PreparedCode prepared_code;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int N = rand(2, 6);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, N),
+                                CodeGenerator::MaxCodeLength(4, N)),
+                           4, N, &code);
+    prepared_code.Build(code);
+    const StateMachine& deficits = prepared_code.GetDeficitsStateMachine();
+    std::set<std::pair<int, std::pair<int, int> > > transitions;
+    for (int j = 0; j < deficits.GetNumberStates(); ++j) {
+      State* state = deficits.GetState(j);
+      for (int k = 0; k < state->transitions.size(); ++k) {
+        ASSERT_TRUE(transitions.insert(std::make_pair(j,
+            std::make_pair(state->transitions[k]->to->id,
+                           state->transitions[k]->event_id))).second);
+      }
+    }
+    ASSERT_EQ(transitions.size(), deficits.GetNumberTransitions());
+  }
+}
+
+// Incremental checks give the same results as full ones after random edits.
+TEST(BijectiveChecker, incremental_check) {
+  static const int kNumberSessions = 200;
+  static const int kNumberEdits = 20;
+  static const int kMaxNumberStates = 4;
+  static const int kMaxElemCodeLength = 4;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  IncrementalBijectiveChecker incremental_checker;
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  int n_incremental_checks = 0;
+  for (int i = 0; i < kNumberSessions; ++i) {
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, 3),
+                                CodeGenerator::MaxCodeLength(4, 3)),
+                           4, 3, &code);
+    const int n_states = rand(1, kMaxNumberStates);
+    CodeGenerator::GenStateMachine(code.size(), n_states, &state_machine);
+    incremental_checker.Init(code, state_machine);
+    for (int j = 0; j < kNumberEdits; ++j) {
+      const std::vector<std::string>& edited_code =
+          incremental_checker.GetCode();
+      const StateMachine& edited_machine =
+          incremental_checker.GetCodeStateMachine();
+      const int n_codes = edited_code.size();
+      switch (rand() % 5) {
+        case 0: {
+          std::string str(rand(1, kMaxElemCodeLength), '0');
+          for (int k = 0; k < str.length(); ++k) {
+            str[k] += rand() % 2;
+          }
+          // Equal elementary codes may be distinguished by state machine.
+          if (rand() % 4 == 0) {
+            str = edited_code[rand() % n_codes];
+          }
+          incremental_checker.AddElemCode(str);
+          break;
+        }
+        case 1:
+          if (n_codes > 1) {
+            incremental_checker.RemoveElemCode(rand(0, n_codes - 1));
+          }
+          break;
+        case 2: {
+          const std::vector<Transition*>& transitions =
+              edited_machine.GetState(rand(0, n_states - 1))->transitions;
+          if (!transitions.empty()) {
+            Transition* trans = transitions[rand() % transitions.size()];
+            incremental_checker.RemoveTransition(trans->from->id,
+                                                 trans->to->id,
+                                                 trans->event_id);
+          }
+          break;
+        }
+        default:
+          incremental_checker.AddTransition(rand(0, n_states - 1),
+                                            rand(0, n_states - 1),
+                                            rand(0, n_codes - 1));
+          break;
+      }
+
+      const bool is_bijective =
+          incremental_checker.IsBijective(&first_bad_word, &second_bad_word);
+      ASSERT_EQ(is_bijective, checker.IsBijective(edited_code,
+                                                  edited_machine));
+      n_incremental_checks += incremental_checker.IsLastCheckIncremental();
+      if (!is_bijective) {
+        ASSERT_NE(first_bad_word, second_bad_word);
+        ASSERT_TRUE(edited_machine.IsRecognized(first_bad_word));
+        ASSERT_TRUE(edited_machine.IsRecognized(second_bad_word));
+        std::string first_word = "";
+        for (int k = 0; k < first_bad_word.size(); ++k) {
+          first_word += edited_code[first_bad_word[k]];
+        }
+        std::string second_word = "";
+        for (int k = 0; k < second_bad_word.size(); ++k) {
+          second_word += edited_code[second_bad_word[k]];
+        }
+        ASSERT_EQ(first_word, second_word);
+      }
+    }
+  }
+  ASSERT_NE(n_incremental_checks, 0);
+}
+
+// Enumerated witnesses are different, valid and ordered by length. Mirrored
+// pairs are not enumerated. Witnesses exist only for not bijective codes.
+TEST(BijectiveChecker, witness_enumerator) {
+  static const int kNumberGenerations = 300;
+  static const int kNumberWitnesses = 30;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  PreparedCode prepared_code;
+  PreparedMachine prepared_machine;
+  BijectiveChecker checker;
+  WitnessEnumerator enumerator;
+  std::vector<int> first_word;
+  std::vector<int> second_word;
+  int n_not_bijective = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, 4),
+                                CodeGenerator::MaxCodeLength(4, 4)),
+                           4, 4, &code);
+    // Witnesses may differ only by equal elementary codes.
+    if (rand() % 4 == 0) {
+      code[rand() % code.size()] = code[rand() % code.size()];
+    }
+    CodeGenerator::GenStateMachine(code.size(), rand(1, 4), &state_machine);
+    prepared_code.Build(code);
+    prepared_machine.Build(state_machine);
+    enumerator.Init(prepared_code, prepared_machine);
+
+    // The first witness is as short as words found by checker.
+    std::vector<int> first_bad_word;
+    std::vector<int> second_bad_word;
+    const bool is_bijective = checker.IsBijective(code, state_machine,
+                                                  &first_bad_word,
+                                                  &second_bad_word);
+    std::set<std::pair<std::vector<int>, std::vector<int> > > witnesses;
+    unsigned last_length = 0;
+    for (int j = 0; j < kNumberWitnesses; ++j) {
+      if (!enumerator.Next(&first_word, &second_word)) {
+        break;
+      }
+      const unsigned length = first_word.size() + second_word.size();
+      if (j == 0) {
+        ASSERT_EQ(length, first_bad_word.size() + second_bad_word.size());
+      }
+      ASSERT_LE(last_length, length);
+      last_length = length;
+      ASSERT_TRUE(witnesses.insert(std::make_pair(first_word,
+                                                  second_word)).second);
+      ASSERT_LT(first_word, second_word);
+      ASSERT_TRUE(state_machine.IsRecognized(first_word));
+      ASSERT_TRUE(state_machine.IsRecognized(second_word));
+      std::string first_str = "";
+      for (int k = 0; k < first_word.size(); ++k) {
+        first_str += code[first_word[k]];
+      }
+      std::string second_str = "";
+      for (int k = 0; k < second_word.size(); ++k) {
+        second_str += code[second_word[k]];
+      }
+      ASSERT_EQ(first_str, second_str);
+    }
+    ASSERT_EQ(witnesses.empty(), is_bijective);
+    n_not_bijective += !witnesses.empty();
+  }
+  ASSERT_NE(n_not_bijective, 0);
+}
+
+// Extends two parsings since the last point of agreement as synonymy state
+// machine does: elementary code is appended to shorter parsing, to lower one
+// if they have the same length. Parsings are trivial until upper one reads
+// the code which lower one has read since the last point of agreement.
+// Returns false if not trivial parsings are longer than max_n_codes.
+static bool FindDecodingDelay(const std::vector<std::string>& code,
+                              const PreparedMachine& machine,
+                              const std::string& upper,
+                              const std::string& lower, int upper_state,
+                              int lower_state, bool is_trivial, int last_code,
+                              int n_codes, int max_n_codes,
+                              unsigned* n_elem_codes, unsigned* n_bits) {
+  if (!is_trivial) {
+    if (n_codes > max_n_codes) {
+      return false;
+    }
+    *n_elem_codes = std::max(*n_elem_codes, static_cast<unsigned>(n_codes));
+    *n_bits = std::max(*n_bits, static_cast<unsigned>(
+                                    std::max(upper.size(), lower.size())));
+  }
+  const bool lower_moves = upper.size() >= lower.size();
+  const bool is_identity = upper.size() == lower.size();
+  for (int i = 0; i < code.size(); ++i) {
+    const int state = machine.GetNextState(lower_moves ? lower_state :
+                                                         upper_state, i);
+    if (state == -1) {
+      continue;
+    }
+    const std::string next_upper = (lower_moves ? upper : upper + code[i]);
+    const std::string next_lower = (lower_moves ? lower + code[i] : lower);
+    const unsigned length = std::min(next_upper.size(), next_lower.size());
+    if (next_upper.compare(0, length, next_lower, 0, length) != 0) {
+      continue;
+    }
+    const bool next_is_identity = next_upper.size() == next_lower.size();
+    const bool next_is_trivial = is_trivial &&
+                                 (is_identity ||
+                                  next_is_identity && i == last_code);
+    if (next_is_trivial && next_is_identity) {
+      // The next point of agreement.
+      continue;
+    }
+    if (!FindDecodingDelay(code, machine, next_upper, next_lower,
+                           lower_moves ? upper_state : state,
+                           lower_moves ? state : lower_state,
+                           next_is_trivial, i, n_codes + 1, max_n_codes,
+                           n_elem_codes, n_bits)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(BijectiveChecker, decoding_delay) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxNumberCodes = 12;
+
+  DecodingDelayAnalyzer analyzer;
+  unsigned n_elem_codes, n_bits;
+  StateMachine all_words_machine;
+  CodeGenerator::GenStateMachine(3, 1, &all_words_machine);
+
+  // Prefix code is decoded instantly.
+  std::vector<std::string> code;
+  code.push_back("0");
+  code.push_back("10");
+  code.push_back("11");
+  ASSERT_TRUE(analyzer.Analyze(code, all_words_machine, &n_elem_codes,
+                               &n_bits));
+  ASSERT_EQ(n_elem_codes, 0);
+  ASSERT_EQ(n_bits, 0);
+
+  // 0111...1 is decoded only at the end.
+  code[1] = "01";
+  ASSERT_FALSE(analyzer.Analyze(code, all_words_machine, &n_elem_codes,
+                                &n_bits));
+
+  // 0, 01 or 011 is known at the next 0.
+  code[2] = "011";
+  ASSERT_TRUE(analyzer.Analyze(code, all_words_machine, &n_elem_codes,
+                               &n_bits));
+  ASSERT_EQ(n_elem_codes, 2);
+  ASSERT_EQ(n_bits, 3);
+
+  // Equal codes 0 are distinguished by the next code: 01 or 00.
+  code.assign(2, "0");
+  code.push_back("1");
+  StateMachine duplicates_machine(4);
+  duplicates_machine.AddTransition(0, 1, 0);
+  duplicates_machine.AddTransition(0, 2, 1);
+  duplicates_machine.AddTransition(1, 3, 2);
+  duplicates_machine.AddTransition(2, 3, 0);
+  ASSERT_TRUE(analyzer.Analyze(code, duplicates_machine, &n_elem_codes,
+                               &n_bits));
+  ASSERT_EQ(n_elem_codes, 3);
+  ASSERT_EQ(n_bits, 2);
+
+  // The same delay as found by extending of parsings.
+  StateMachine state_machine;
+  PreparedCode prepared_code;
+  PreparedMachine prepared_machine;
+  std::vector<int> reachable_states;
+  int n_bounded = 0;
+  int n_unbounded = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, 4),
+                                CodeGenerator::MaxCodeLength(4, 4)),
+                           4, 4, &code);
+    if (rand() % 4 == 0) {
+      code[rand() % code.size()] = code[rand() % code.size()];
+    }
+    CodeGenerator::GenStateMachine(code.size(), rand(1, 3), &state_machine);
+    prepared_code.Build(code);
+    prepared_machine.Build(state_machine);
+    const bool is_bounded = analyzer.Analyze(prepared_code, prepared_machine,
+                                             &n_elem_codes, &n_bits);
+
+    // Points of agreement are at states reachable from start one.
+    reachable_states.assign(1, 0);
+    std::vector<bool> is_reachable(state_machine.GetNumberStates(), false);
+    is_reachable[0] = true;
+    for (int j = 0; j < reachable_states.size(); ++j) {
+      for (int k = 0; k < code.size(); ++k) {
+        const int to = prepared_machine.GetNextState(reachable_states[j], k);
+        if (to != -1 && !is_reachable[to]) {
+          is_reachable[to] = true;
+          reachable_states.push_back(to);
+        }
+      }
+    }
+    bool found = true;
+    unsigned expected_n_elem_codes = 0;
+    unsigned expected_n_bits = 0;
+    for (int j = 0; j < reachable_states.size() && found; ++j) {
+      found = FindDecodingDelay(code, prepared_machine, "", "",
+                                reachable_states[j], reachable_states[j],
+                                true, -1, 0, kMaxNumberCodes,
+                                &expected_n_elem_codes, &expected_n_bits);
+    }
+    if (is_bounded) {
+      ASSERT_TRUE(found);
+      ASSERT_EQ(n_elem_codes, expected_n_elem_codes);
+      ASSERT_EQ(n_bits, expected_n_bits);
+      ++n_bounded;
+    } else {
+      ASSERT_FALSE(found);
+      ++n_unbounded;
+    }
+  }
+  ASSERT_NE(n_bounded, 0);
+  ASSERT_NE(n_unbounded, 0);
+}
+
+// Code over alphabet of radix symbols is bijective iff it's binary image by
+// symbols of fixed length is bijective.
+template<int kRadix>
+void CheckRadixCodes(int n_bits_per_symbol) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxNumberCodes = 5;
+  static const int kMaxLength = 3;
+
+  std::vector<std::string> code;
+  std::vector<std::string> binary_code;
+  StateMachine state_machine;
+  BijectiveChecker checker;
+  std::vector<int> first_bad_word;
+  std::vector<int> second_bad_word;
+  int n_not_bijective = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, kMaxNumberCodes);
+    code.resize(n_codes);
+    binary_code.resize(n_codes);
+    for (int j = 0; j < n_codes; ++j) {
+      code[j].resize(rand(1, kMaxLength));
+      binary_code[j] = "";
+      for (int k = 0; k < code[j].size(); ++k) {
+        // Few symbols for ambiguous codes, including the last one.
+        const int symbol = (rand() % 4 ? rand() % 2 : kRadix - 1);
+        code[j][k] = Alphabet<kRadix>::kFirstChar + symbol;
+        for (int l = 0; l < n_bits_per_symbol; ++l) {
+          binary_code[j] += '0' + ((symbol >> l) & 1);
+        }
+      }
+    }
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+
+    const bool is_bijective =
+        checker.IsBijective<kRadix>(code, state_machine, &first_bad_word,
+                                    &second_bad_word);
+    // Code of this check isn't kept.
+    ASSERT_FALSE(checker.WriteDeficitsStateMachine("deficits.dot"));
+    ASSERT_FALSE(checker.WriteSynonymyStateMachine("synonymy.dot"));
+    ASSERT_EQ(is_bijective, checker.IsBijective(binary_code, state_machine));
+    if (!is_bijective) {
+      ++n_not_bijective;
+      ASSERT_NE(first_bad_word, second_bad_word);
+      std::string first_word = "";
+      for (int k = 0; k < first_bad_word.size(); ++k) {
+        first_word += code[first_bad_word[k]];
+      }
+      std::string second_word = "";
+      for (int k = 0; k < second_bad_word.size(); ++k) {
+        second_word += code[second_bad_word[k]];
+      }
+      ASSERT_EQ(first_word, second_word);
+    }
+  }
+  ASSERT_NE(n_not_bijective, 0);
+}
+
+TEST(BijectiveChecker, radix) {
+  CheckRadixCodes<3>(2);
+  CheckRadixCodes<4>(2);
+  CheckRadixCodes<256>(8);
+}
+
+// Codes checked at compile time.
+static constexpr const char* kPrefixCode[] = { "0", "10", "11" };
+static constexpr const char* kAmbiguousCode[] = { "0", "01", "10" };
+static constexpr const char* kSuffixCode[] = { "0", "01", "11" };
+static constexpr int kAllWordsMachine[][3] = { { 0, 0, 0 }, { 0, 0, 1 },
+                                               { 0, 0, 2 } };
+static_assert(StaticBijectiveChecker::IsBijective(kPrefixCode, 1,
+                                                  kAllWordsMachine), "");
+static_assert(StaticBijectiveChecker::IsBijective(kSuffixCode, 1,
+                                                  kAllWordsMachine), "");
+static_assert(!StaticBijectiveChecker::IsBijective(kAmbiguousCode, 1,
+                                                   kAllWordsMachine), "");
+// Equal elementary codes are not distinguished by state machine.
+static constexpr const char* kDuplicatesCode[] = { "0", "0" };
+static constexpr int kDuplicatesMachine[][3] = { { 0, 1, 0 }, { 0, 1, 1 } };
+static_assert(!StaticBijectiveChecker::IsBijective(kDuplicatesCode, 2,
+                                                   kDuplicatesMachine), "");
+
+// The same results as BijectiveChecker gives.
+TEST(BijectiveChecker, static_check) {
+  static const int kNumberGenerations = 2000;
+  static const int kMaxNumberStates = 4;
+
+  std::vector<std::string> code;
+  std::vector<const char*> code_ptrs;
+  StateMachine state_machine;
+  std::vector<int> transitions;
+  BijectiveChecker checker;
+  int n_not_bijective = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 5);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, n_codes),
+                                CodeGenerator::MaxCodeLength(4, n_codes)),
+                           4, n_codes, &code);
+    if (rand() % 4 == 0) {
+      code[rand() % n_codes] = code[rand() % n_codes];
+    }
+    const int n_states = rand(1, kMaxNumberStates);
+    CodeGenerator::GenStateMachine(n_codes, n_states, &state_machine);
+
+    code_ptrs.resize(n_codes);
+    for (int j = 0; j < n_codes; ++j) {
+      code_ptrs[j] = code[j].c_str();
+    }
+    transitions.clear();
+    for (int j = 0; j < n_states; ++j) {
+      const std::vector<Transition*>& state_transitions =
+          state_machine.GetState(j)->transitions;
+      for (int k = 0; k < state_transitions.size(); ++k) {
+        transitions.push_back(j);
+        transitions.push_back(state_transitions[k]->to->id);
+        transitions.push_back(state_transitions[k]->event_id);
+      }
+    }
+    const bool is_bijective = checker.IsBijective(code, state_machine);
+    ASSERT_EQ(StaticBijectiveChecker::IsBijective(
+                  &code_ptrs[0], n_codes, n_states,
+                  reinterpret_cast<const int(*)[3]>(&transitions[0]),
+                  transitions.size() / 3),
+              is_bijective);
+    n_not_bijective += !is_bijective;
+  }
+  ASSERT_NE(n_not_bijective, 0);
+}
@@ -0,0 +1,46 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include <algorithm>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "include/bit_string.h"
+#include "include/structures.h"
+
+static std::string RandomWord(int length) {
+  std::string word(length, '0');
+  for (int i = 0; i < length; ++i) {
+    word[i] += rand() % 2;
+  }
+  return word;
+}
+
+// Compare operations of packed words with the same ones of strings.
+TEST(BitString, operations) {
+  static const int kNumberGenerations = 1000;
+  static const int kMaxLength = 200;
+
+  BitString bits;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const std::string word = RandomWord(rand(0, kMaxLength));
+    bits.Assign(word);
+    ASSERT_EQ(bits.length(), word.length());
+    for (int j = 0; j < word.length(); ++j) {
+      ASSERT_EQ(bits.GetBit(j), word[j] == '1');
+    }
+    if (word.empty()) {
+      continue;
+    }
+
+    const int pos = rand(0, word.length() - 1);
+    const int n_bits = rand(0, std::min<int>(64, word.length() - pos));
+    uint64_t expected_bits = 0;
+    for (int j = n_bits - 1; j >= 0; --j) {
+      expected_bits = (expected_bits << 1) | (word[pos + j] - '0');
+    }
+    ASSERT_EQ(bits.GetBits(pos, n_bits), expected_bits);
+  }
+}
@@ -0,0 +1,228 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/code_automaton.h"
+#include "include/code_tree.h"
+#include "include/simple_suffix_tree.h"
+#include "include/structures.h"
+
+// Compare found codes with codes found by strings comparison.
+TEST(CodeTree, find) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxNumberCodes = 20;
+  static const int kMaxLength = 8;
+
+  CodeTree code_tree;
+  std::vector<ElementaryCode*> code;
+  std::vector<ElementaryCode*> upper_elem_codes;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(1, kMaxNumberCodes);
+    for (int j = 0; j < n_codes; ++j) {
+      std::string str(rand(1, kMaxLength), '0');
+      for (int k = 0; k < str.length(); ++k) {
+        str[k] += rand() % 2;
+      }
+      code.push_back(new ElementaryCode(j, str));
+    }
+    code_tree.Build(code);
+
+    const std::vector<ElementaryCode*>& sorted = code_tree.GetSortedElemCodes();
+    ASSERT_EQ(sorted.size(), n_codes);
+    for (int j = 1; j < n_codes; ++j) {
+      ASSERT_LE(sorted[j - 1]->str, sorted[j]->str);
+    }
+
+    for (int j = 0; j < n_codes; ++j) {
+      const std::string& str = code[j]->str;
+      const int pos = rand(0, str.length() - 1);
+      const int length = rand(1, str.length() - pos);
+      const std::string word = str.substr(pos, length);
+      const int node_id = code_tree.Find(code[j]->bits, pos, length,
+                                         &upper_elem_codes);
+      int n_lower = 0;
+      for (int k = 0; k < n_codes; ++k) {
+        n_lower += code[k]->str.compare(0, length, word) == 0;
+      }
+      if (node_id == -1) {
+        ASSERT_EQ(n_lower, 0);
+        continue;
+      }
+
+      // Prefixes of word. Only the last of equal codes is found.
+      std::vector<std::string> upper_strs;
+      for (int k = 0; k < n_codes; ++k) {
+        if (word.compare(0, code[k]->str.length(), code[k]->str) == 0 &&
+            std::find(upper_strs.begin(), upper_strs.end(), code[k]->str) ==
+            upper_strs.end()) {
+          upper_strs.push_back(code[k]->str);
+        }
+      }
+      ASSERT_EQ(upper_elem_codes.size(), upper_strs.size());
+      for (int k = 0; k < upper_elem_codes.size(); ++k) {
+        ASSERT_EQ(word.compare(0, upper_elem_codes[k]->str.length(),
+                               upper_elem_codes[k]->str), 0);
+      }
+
+      // Codes with prefix word.
+      unsigned begin, end;
+      code_tree.GetLowerElemCodes(node_id, &begin, &end);
+      ASSERT_EQ(end - begin, n_lower);
+      for (unsigned k = begin; k < end; ++k) {
+        ASSERT_EQ(sorted[k]->str.compare(0, length, word), 0);
+      }
+    }
+
+    for (int j = 0; j < n_codes; ++j) {
+      delete code[j];
+    }
+    code.clear();
+  }
+}
+
+// Tree is built and traversed without recursion.
+TEST(CodeTree, long_code) {
+  static const int kLength = 1000000;
+
+  std::vector<ElementaryCode*> code;
+  code.push_back(new ElementaryCode(0, std::string(kLength, '1')));
+  code.push_back(new ElementaryCode(1, "1"));
+  CodeTree code_tree(code);
+  ASSERT_EQ(code_tree.GetSortedElemCodes()[0], code[1]);
+  ASSERT_EQ(code_tree.GetElemCode(code_tree.Find(code[0]->bits)), code[0]);
+  delete code[0];
+  delete code[1];
+}
+
+// Automaton finds all elementary codes which are suffixes of read word.
+TEST(CodeTree, automaton) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxNumberCodes = 20;
+  static const int kMaxLength = 6;
+  static const int kWordLength = 50;
+
+  CodeTree code_tree;
+  CodeAutomaton automaton;
+  std::vector<ElementaryCode*> code;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(1, kMaxNumberCodes);
+    for (int j = 0; j < n_codes; ++j) {
+      std::string str(rand(1, kMaxLength), '0');
+      for (int k = 0; k < str.length(); ++k) {
+        str[k] += rand() % 2;
+      }
+      code.push_back(new ElementaryCode(j, str));
+    }
+    code_tree.Build(code);
+    automaton.Build(code_tree);
+
+    std::string word(kWordLength, '0');
+    for (int j = 0; j < kWordLength; ++j) {
+      word[j] += rand() % 2;
+    }
+    int state = 0;
+    for (int j = 0; j < kWordLength; ++j) {
+      state = automaton.GetNextState(state, word[j] - '0');
+
+      // State is the longest suffix which is prefix of some code.
+      const std::string read = word.substr(0, j + 1);
+      int max_length = 0;
+      for (int k = 0; k < n_codes; ++k) {
+        for (int length = 1; length <= code[k]->str.length() &&
+                             length <= read.length(); ++length) {
+          if (read.compare(read.length() - length, length, code[k]->str,
+                           0, length) == 0) {
+            max_length = std::max(max_length, length);
+          }
+        }
+      }
+      ASSERT_EQ(automaton.GetDepth(state), max_length);
+
+      std::vector<std::string> outputs;
+      for (int output = automaton.GetOutput(state); output != -1;
+           output = automaton.GetOutput(automaton.GetFailure(output))) {
+        outputs.push_back(code_tree.GetElemCode(output)->str);
+      }
+      std::vector<std::string> suffixes;
+      for (int k = 0; k < n_codes; ++k) {
+        const std::string& str = code[k]->str;
+        if (str.length() <= read.length() &&
+            read.compare(read.length() - str.length(), str.length(),
+                         str) == 0 &&
+            std::find(suffixes.begin(), suffixes.end(), str) ==
+            suffixes.end()) {
+          suffixes.push_back(str);
+        }
+      }
+      std::sort(outputs.begin(), outputs.end());
+      std::sort(suffixes.begin(), suffixes.end());
+      ASSERT_EQ(outputs, suffixes);
+    }
+
+    for (int j = 0; j < n_codes; ++j) {
+      delete code[j];
+    }
+    code.clear();
+  }
+}
+
+// Compare suffixes ids with ids given to distinct suffixes strings in order of
+// first occurrence.
+TEST(SimpleSuffixTree, suffixes_ids) {
+  static const int kNumberGenerations = 300;
+  static const int kMaxNumberCodes = 20;
+  static const int kMaxLength = 10;
+
+  SimpleSuffixTree suffix_tree;
+  std::vector<ElementaryCode*> code;
+  std::vector<Suffix*> suffixes;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(1, kMaxNumberCodes);
+    for (int j = 0; j < n_codes; ++j) {
+      std::string str(rand(1, kMaxLength), '0');
+      for (int k = 0; k < str.length(); ++k) {
+        str[k] += rand() % 2;
+      }
+      code.push_back(new ElementaryCode(j, str));
+    }
+    suffix_tree.Build(&code);
+    suffix_tree.GetSuffixes(&suffixes);
+
+    std::map<std::string, int> ids;
+    std::map<std::string, int> n_owners;
+    ids[""] = 0;
+    for (int j = 0; j < n_codes; ++j) {
+      const std::string& str = code[j]->str;
+      ASSERT_EQ(code[j]->suffixes.size(), str.length() + 1);
+      for (int k = 0; k <= str.length(); ++k) {
+        const std::string suffix = str.substr(k);
+        if (ids.find(suffix) == ids.end()) {
+          const int id = ids.size();
+          ids[suffix] = id;
+        }
+        ++n_owners[suffix];
+        Suffix* found = code[j]->suffixes[k];
+        ASSERT_EQ(found->id, ids[suffix]);
+        ASSERT_EQ(found->length, suffix.length());
+        ASSERT_EQ(suffixes[found->id], found);
+      }
+    }
+    ASSERT_EQ(suffixes.size(), ids.size());
+    for (std::map<std::string, int>::iterator it = ids.begin();
+         it != ids.end(); ++it) {
+      ASSERT_EQ(suffixes[it->second]->owners.size(), n_owners[it->first]);
+    }
+
+    for (int j = 0; j < n_codes; ++j) {
+      delete code[j];
+    }
+    code.clear();
+  }
+}
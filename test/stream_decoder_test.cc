@@ -0,0 +1,369 @@
+// Copyright © 2016 Dmitry Kurtaev. All rights reserved.
+// License: MIT License (see LICENSE)
+// e-mail: dmitry.kurtaev@gmail.com
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "include/code_generator.h"
+#include "include/decoding_transducer.h"
+#include "include/parallel_decoder.h"
+#include "include/prepared_machine.h"
+#include "include/state_machine.h"
+#include "include/stream_decoder.h"
+#include "include/structures.h"
+
+// Random word recognized by code state machine. Returns false if it's not
+// found.
+static bool GenWord(const PreparedMachine& machine, int n_codes,
+                    int max_length, std::vector<int>* word) {
+  static const int kNumberAttempts = 100;
+
+  const int final_state = machine.GetNumberStates() - 1;
+  std::vector<int> events;
+  for (int i = 0; i < kNumberAttempts; ++i) {
+    const int length = rand(0, max_length);
+    int state = 0;
+    word->clear();
+    for (int j = 0; j < length && state != -1; ++j) {
+      events.clear();
+      for (int k = 0; k < n_codes; ++k) {
+        if (machine.GetNextState(state, k) != -1) {
+          events.push_back(k);
+        }
+      }
+      if (events.empty()) {
+        state = -1;
+      } else {
+        word->push_back(events[rand() % events.size()]);
+        state = machine.GetNextState(state, word->back());
+      }
+    }
+    if (state == final_state) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Packs bits [pos, pos + length) of string of '0' and '1' characters.
+static void Pack(const std::string& bits, unsigned pos, unsigned length,
+                 std::vector<uint8_t>* data) {
+  data->assign((length + 7) / 8 + 1, 0);
+  for (unsigned i = 0; i < length; ++i) {
+    (*data)[i / 8] |= (bits[pos + i] - '0') << (i % 8);
+  }
+}
+
+// Decodes stream pushed by random chunks.
+static bool Decode(const std::string& bits, StreamDecoder* decoder,
+                   std::vector<int>* symbols) {
+  std::vector<uint8_t> data;
+  symbols->resize(bits.size() + decoder->GetMaxNumberPending());
+  int n_symbols = 0;
+  for (unsigned pos = 0; pos < bits.size();) {
+    const unsigned length = std::min<unsigned>(rand(1, 20),
+                                               bits.size() - pos);
+    Pack(bits, pos, length, &data);
+    const int n_decoded = decoder->Push(&data[0], length,
+                                        &(*symbols)[n_symbols]);
+    if (n_decoded == -1) {
+      decoder->Reset();
+      return false;
+    }
+    n_symbols += n_decoded;
+    pos += length;
+  }
+  const int n_decoded = decoder->Finish(&(*symbols)[n_symbols]);
+  if (n_decoded == -1) {
+    return false;
+  }
+  symbols->resize(n_symbols + n_decoded);
+  return true;
+}
+
+TEST(StreamDecoder, fixed_code) {
+  StreamDecoder decoder;
+  std::vector<int> symbols;
+  StateMachine state_machine;
+  CodeGenerator::GenStateMachine(3, 1, &state_machine);
+
+  // Not bijective code.
+  std::vector<std::string> code;
+  code.push_back("0");
+  code.push_back("01");
+  code.push_back("10");
+  ASSERT_FALSE(decoder.Init(code, state_machine));
+
+  // Unbounded delay.
+  code[2] = "11";
+  ASSERT_FALSE(decoder.Init(code, state_machine));
+
+  code[2] = "011";
+  ASSERT_TRUE(decoder.Init(code, state_machine));
+  ASSERT_TRUE(decoder.IsTransducerDriven());
+  ASSERT_TRUE(Decode("0110010", &decoder, &symbols));
+  ASSERT_EQ(symbols.size(), 4);
+  ASSERT_EQ(symbols[0], 2);
+  ASSERT_EQ(symbols[1], 0);
+  ASSERT_EQ(symbols[2], 1);
+  ASSERT_EQ(symbols[3], 0);
+  ASSERT_FALSE(Decode("0100111", &decoder, &symbols));
+  ASSERT_TRUE(Decode("", &decoder, &symbols));
+  ASSERT_TRUE(symbols.empty());
+}
+
+// Decoded words are encoded ones. Decoder without transducer moves
+// hypotheses.
+TEST(StreamDecoder, random_codes) {
+  static const int kNumberGenerations = 500;
+  static const int kNumberWords = 10;
+  static const int kMaxWordLength = 50;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  PreparedMachine prepared_machine;
+  StreamDecoder decoder;
+  StreamDecoder hypotheses_decoder;
+  std::vector<int> word;
+  std::vector<int> symbols;
+  int n_decoded_words = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 5);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, n_codes),
+                                CodeGenerator::MaxCodeLength(4, n_codes)),
+                           4, n_codes, &code);
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+    if (!decoder.Init(code, state_machine)) {
+      continue;
+    }
+    ASSERT_TRUE(hypotheses_decoder.Init(code, state_machine, 0));
+    ASSERT_FALSE(hypotheses_decoder.IsTransducerDriven());
+    prepared_machine.Build(state_machine);
+    for (int j = 0; j < kNumberWords; ++j) {
+      if (!GenWord(prepared_machine, n_codes, kMaxWordLength, &word)) {
+        break;
+      }
+      std::string bits = "";
+      for (int k = 0; k < word.size(); ++k) {
+        bits += code[word[k]];
+      }
+      ASSERT_TRUE(Decode(bits, &decoder, &symbols));
+      ASSERT_EQ(symbols, word);
+      ASSERT_TRUE(Decode(bits, &hypotheses_decoder, &symbols));
+      ASSERT_EQ(symbols, word);
+      ++n_decoded_words;
+    }
+  }
+  ASSERT_NE(n_decoded_words, 0);
+}
+
+// Prefix codes with codes longer than lookup tables.
+TEST(StreamDecoder, prefix_codes) {
+  static const int kNumberGenerations = 300;
+  static const int kNumberWords = 10;
+  static const int kMaxWordLength = 50;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  PreparedMachine prepared_machine;
+  StreamDecoder decoder;
+  std::vector<int> word;
+  std::vector<int> symbols;
+  int n_decoded_words = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 30);
+    CodeGenerator::GenPrefixCode(rand(5, 30), n_codes, &code);
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+    ASSERT_TRUE(decoder.Init(code, state_machine));
+    ASSERT_TRUE(decoder.IsTableDriven());
+    prepared_machine.Build(state_machine);
+    for (int j = 0; j < kNumberWords; ++j) {
+      if (!GenWord(prepared_machine, n_codes, kMaxWordLength, &word)) {
+        break;
+      }
+      std::string bits = "";
+      for (int k = 0; k < word.size(); ++k) {
+        bits += code[word[k]];
+      }
+      ASSERT_TRUE(Decode(bits, &decoder, &symbols));
+      ASSERT_EQ(symbols, word);
+      ++n_decoded_words;
+      if (bits.empty()) {
+        continue;
+      }
+
+      // Stream without the last bit is decoded only if it's encoded word.
+      bits.resize(bits.size() - 1);
+      if (Decode(bits, &decoder, &symbols)) {
+        std::string decoded_bits = "";
+        for (int k = 0; k < symbols.size(); ++k) {
+          decoded_bits += code[symbols[k]];
+        }
+        ASSERT_EQ(decoded_bits, bits);
+        ASSERT_TRUE(state_machine.IsRecognized(symbols));
+      }
+    }
+  }
+  ASSERT_NE(n_decoded_words, 0);
+}
+
+// Transducer decodes the same words as decoder, by whole stream and by
+// chunks.
+TEST(DecodingTransducer, random_codes) {
+  static const int kNumberGenerations = 300;
+  static const int kNumberWords = 10;
+  static const int kMaxWordLength = 50;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  PreparedMachine prepared_machine;
+  StreamDecoder decoder;
+  DecodingTransducer transducer;
+  std::vector<int> word;
+  std::vector<int> symbols;
+  std::vector<uint8_t> data;
+  int n_decoded_words = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 5);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, n_codes),
+                                CodeGenerator::MaxCodeLength(4, n_codes)),
+                           4, n_codes, &code);
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+    const bool is_built = transducer.Build(code, state_machine);
+    ASSERT_EQ(is_built, decoder.Init(code, state_machine));
+    if (!is_built) {
+      continue;
+    }
+    prepared_machine.Build(state_machine);
+    for (int j = 0; j < kNumberWords; ++j) {
+      if (!GenWord(prepared_machine, n_codes, kMaxWordLength, &word)) {
+        break;
+      }
+      std::string bits = "";
+      for (int k = 0; k < word.size(); ++k) {
+        bits += code[word[k]];
+      }
+      Pack(bits, 0, bits.size(), &data);
+      symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      const int n_symbols = transducer.Decode(&data[0], bits.size(),
+                                              &symbols[0]);
+      ASSERT_EQ(n_symbols, word.size());
+      symbols.resize(n_symbols);
+      ASSERT_EQ(symbols, word);
+
+      int state = DecodingTransducer::kStartState;
+      symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      int n_chunks_symbols = 0;
+      for (unsigned pos = 0; pos < bits.size();) {
+        const unsigned length = std::min<unsigned>(rand(1, 20),
+                                                   bits.size() - pos);
+        Pack(bits, pos, length, &data);
+        const int n_decoded = transducer.Push(&data[0], length, &state,
+                                              &symbols[n_chunks_symbols]);
+        ASSERT_NE(n_decoded, -1);
+        n_chunks_symbols += n_decoded;
+        pos += length;
+      }
+      const int n_decoded = transducer.Finish(state,
+                                              &symbols[n_chunks_symbols]);
+      ASSERT_NE(n_decoded, -1);
+      symbols.resize(n_chunks_symbols + n_decoded);
+      ASSERT_EQ(symbols, word);
+      ++n_decoded_words;
+
+      // Stream without the last bit is decoded only if it's encoded word.
+      if (bits.empty()) {
+        continue;
+      }
+      bits.resize(bits.size() - 1);
+      Pack(bits, 0, bits.size(), &data);
+      symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      const bool is_decoded = transducer.Decode(&data[0], bits.size(),
+                                                &symbols[0]) != -1;
+      ASSERT_EQ(is_decoded, Decode(bits, &decoder, &symbols));
+    }
+  }
+  ASSERT_NE(n_decoded_words, 0);
+}
+
+// Stream decoded by chunks in parallel is decoded the same as by transducer.
+// Long words are split to several chunks. Pool of not positive number of
+// threads has single thread.
+TEST(ParallelDecoder, random_codes) {
+  static const int kNumberGenerations = 100;
+  static const int kNumberWords = 3;
+  static const int kMaxWordLength = 100000;
+
+  std::vector<std::string> code;
+  StateMachine state_machine;
+  PreparedMachine prepared_machine;
+  DecodingTransducer transducer;
+  ParallelDecoder decoder(3);
+  ParallelDecoder single_thread_decoder(0);
+  std::vector<int> word;
+  std::vector<int> symbols;
+  std::vector<int> parallel_symbols;
+  std::vector<uint8_t> data;
+  int n_speculative_words = 0;
+  for (int i = 0; i < kNumberGenerations; ++i) {
+    const int n_codes = rand(2, 5);
+    CodeGenerator::GenCode(rand(CodeGenerator::MinCodeLength(4, n_codes),
+                                CodeGenerator::MaxCodeLength(4, n_codes)),
+                           4, n_codes, &code);
+    CodeGenerator::GenStateMachine(n_codes, rand(1, 3), &state_machine);
+    if (!transducer.Build(code, state_machine)) {
+      continue;
+    }
+    const bool is_speculative = decoder.Init(&transducer);
+    ASSERT_EQ(is_speculative, decoder.IsSpeculative());
+    ASSERT_EQ(single_thread_decoder.Init(&transducer), is_speculative);
+    prepared_machine.Build(state_machine);
+    for (int j = 0; j < kNumberWords; ++j) {
+      if (!GenWord(prepared_machine, n_codes, kMaxWordLength, &word)) {
+        break;
+      }
+      std::string bits = "";
+      for (int k = 0; k < word.size(); ++k) {
+        bits += code[word[k]];
+      }
+      Pack(bits, 0, bits.size(), &data);
+      parallel_symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      const int n_symbols = decoder.Decode(&data[0], bits.size(),
+                                           &parallel_symbols[0]);
+      ASSERT_EQ(n_symbols, word.size());
+      parallel_symbols.resize(n_symbols);
+      ASSERT_EQ(parallel_symbols, word);
+      parallel_symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      ASSERT_EQ(single_thread_decoder.Decode(&data[0], bits.size(),
+                                             &parallel_symbols[0]),
+                n_symbols);
+      parallel_symbols.resize(n_symbols);
+      ASSERT_EQ(parallel_symbols, word);
+      n_speculative_words += is_speculative;
+
+      // Corrupted stream.
+      if (bits.empty()) {
+        continue;
+      }
+      const int pos = rand() % bits.size();
+      data[pos / 8] ^= 1 << (pos % 8);
+      symbols.resize(bits.size() + transducer.GetMaxNumberPending());
+      parallel_symbols.resize(symbols.size());
+      const int n_expected = transducer.Decode(&data[0], bits.size(),
+                                               &symbols[0]);
+      ASSERT_EQ(decoder.Decode(&data[0], bits.size(), &parallel_symbols[0]),
+                n_expected);
+      if (n_expected != -1) {
+        symbols.resize(n_expected);
+        parallel_symbols.resize(n_expected);
+        ASSERT_EQ(parallel_symbols, symbols);
+      }
+    }
+  }
+  ASSERT_NE(n_speculative_words, 0);
+}